@@ -41,6 +41,7 @@ UNISHADER_BEGIN
 
 class ShaderProgram;
 class BufferBase;
+class Varying;
 template <typename T> class Buffer;
 
 //!	Attribute class.
@@ -93,7 +94,8 @@ public:
 	*/
 	class SignalID{
 	public:
-		enum Types{CHANGED //!< Class changed its state.
+		enum Types{CHANGED, //!< Class changed its state.
+					SOURCE_CHANGED //!< Source of data (buffer, offset or stride) changed, but data format stayed the same.
 		}; 
 	};
 
@@ -106,9 +108,19 @@ public:
 	*/
 	void connectBuffer(std::shared_ptr<BufferBase> buffer, size_t offset = 0, size_t stride = 0);
 
-	//! Disconnect buffer from attribute.
+	//! Connect varying to attribute and set its buffer as data source.
 	/*!
-		\sa connectBuffer()
+		Values recorded by varying of other shader program are read directly from
+		its output buffer without copying. Buffer, offset and stride are taken from
+		varying whenever it changes, so interleaved outputs are handled as well.
+		\param varying Varying.
+		\sa disconnectBuffer().
+	*/
+	void connectVarying(SafePtr<Varying> varying);
+
+	//! Disconnect buffer or varying from attribute.
+	/*!
+		\sa connectBuffer(), connectVarying()
 	*/
 	void disconnectBuffer();
 
@@ -119,6 +131,23 @@ public:
 	*/
 	void normalize(bool norm);
 
+	//! Set divisor.
+	/*!
+		Attribute with non-zero divisor advances once per divisor instances instead of
+		once per vertex, so single value can be shared by all vertices of instance.
+		Used with UniShader::renderInstanced().
+		Non-zero divisor requires OpenGL 3.3 or ARB_instanced_arrays.
+		\param divisor Number of instances sharing one value. Zero advances per vertex.
+		\return True if divisor is supported by graphics card.
+	*/
+	bool setDivisor(unsigned int divisor);
+
+	//! Get divisor.
+	/*!
+		\return Divisor.
+	*/
+	unsigned int getDivisor() const;
+
 	//! Get buffer offset.
 	/*!
 		\return Buffer offset.
@@ -177,9 +206,32 @@ public:
 	//! Apply attribute settings.
 	/*!
 		Modify OpenGL context with settings stored in this class.
+		Only settings changed since last apply are issued. If ARB_vertex_attrib_binding
+		is supported, data format is set up once with glVertexAttribFormat and change of
+		buffer, offset or stride is applied with single glBindVertexBuffer call.
+		Otherwise glVertexAttribPointer is used.
 	*/
 	void apply();
 
+	//! Needs apply?
+	/*!
+		\return True if format or source changed since last apply().
+	*/
+	bool needsApply();
+
+	//! Invalidate applied state.
+	/*!
+		Force next apply() to issue all settings, e.g. when vertex array object was recreated.
+	*/
+	void invalidate();
+
+	//! Is source outdated?
+	/*!
+		Check if buffer, offset or stride of connected varying changed since last apply().
+		\return True if attribute needs to be applied again.
+	*/
+	bool isSourceOutdated();
+
 	//! Handle incoming signal.
 	/*!
 		\param signalID Signal identifier.
@@ -188,16 +240,34 @@ public:
 	*/
 	virtual bool handleSignal(unsigned int signalID, const ObjectBase* callerPtr);
 private:
+	friend class ShaderInput;
 	ShaderProgram& m_program;
+	bool resolveVarying();
+	bool resolveFormat(unsigned int& dataType, size_t& elemSize);
+	bool resolveSource(unsigned int& bufferID, size_t& offset, size_t& stride);
+	bool hasSource() const;
+	bool applyFormat();
+	void sourceApplied(unsigned int bufferID, size_t offset);
+
 	std::shared_ptr<BufferBase> m_buffer;
+	SafePtr<Varying> m_varying;
+	bool m_varyingConnected;
+	unsigned int m_appliedBufferID;
+	size_t m_appliedOffset;
 	GLSLType m_type;
 	std::string m_name;
 	size_t m_offset;
 	size_t m_stride;
+	unsigned int m_divisor;
+	unsigned int m_appliedDivisor;
 	int m_location;
 	ReadingMode m_readingMode;
 	bool m_normalize;
 	bool m_prepared;
+	bool m_useBinding;
+	bool m_enabled;
+	bool m_formatDirty;
+	bool m_sourceDirty;
 };
 
 UNISHADER_END
@@ -31,21 +31,38 @@
 #include <UniShader/Utility.h>
 #include <UniShader/ObjectBase.h>
 #include <UniShader/Signal.h>
+#include <UniShader/Readback.h>
+#include <UniShader/MappedView.h>
 
 #include <memory>
 #include <vector>
 #include <string>
 #include <sstream>
 #include <typeinfo>
+#include <functional>
 
 UNISHADER_BEGIN
 
+//! Buffer range.
+/*!
+	Range of elements stored in buffer.
+	Zero count means all elements from offset to the end of buffer.
+*/
+
+struct BufferRange{
+	BufferRange(unsigned int first = 0, unsigned int size = 0):offset(first),count(size){}
+	unsigned int offset; //!< Index of first element.
+	unsigned int count; //!< Number of elements.
+};
+
 //!	Buffer base class.
 /*!
 	Buffer base stores raw OpenGL information about buffer object. 
 */
 
 class UniShader_API BufferBase : public SignalSender, public ObjectBase{
+	template <typename T> friend class MappedView;
+	friend class UploadBatch;
 protected:
 	BufferBase();
 public:
@@ -95,6 +112,38 @@ public:
 		operator myEnum(){ return m_en; }
 	};
 
+	//! Map access flags.
+	/*!
+		Flags specifying access to mapped range of buffer. Flags can be combined.
+	*/
+	class MapAccess{
+	public:
+		enum Flags{READ = 1 << 0, //!< Mapped data will be read.
+					WRITE = 1 << 1, //!< Mapped data will be written.
+					INVALIDATE_RANGE = 1 << 2, //!< Previous contents of range can be discarded. Can't be used with READ.
+					UNSYNCHRONIZED = 1 << 3, //!< Don't wait for pending operations on buffer.
+					PERSISTENT = 1 << 4, //!< Range stays mapped while used by OpenGL. Requires storage with StorageFlags::PERSISTENT.
+					COHERENT = 1 << 5 //!< Writes are visible without explicit synchronization. Requires PERSISTENT and storage with StorageFlags::COHERENT.
+		};
+	};
+
+	//! Storage flags.
+	/*!
+		Flags specifying intended usage of immutable storage. Unlike frequency
+		and nature modes, these are requirements rather than hints. Flags can be combined.
+	*/
+	class StorageFlags{
+	public:
+		enum Flags{NONE = 0, //!< Storage is only accessed by OpenGL commands.
+					DYNAMIC = 1 << 0, //!< Contents can be updated by setSubData() and setRanges().
+					MAP_READ = 1 << 1, //!< Storage can be mapped for reading.
+					MAP_WRITE = 1 << 2, //!< Storage can be mapped for writing.
+					PERSISTENT = 1 << 3, //!< Storage can stay mapped while used by OpenGL.
+					COHERENT = 1 << 4, //!< Writes to persistently mapped storage are visible without explicit synchronization.
+					CLIENT_STORAGE = 1 << 5 //!< Prefer storage in system memory.
+		};
+	};
+
 	//! Signal identifier enum.
 	/*!
 		Describe signal sent from this class.
@@ -118,6 +167,61 @@ public:
 	*/
 	unsigned int getGlID() const;
 
+	//! Get storage offset.
+	/*!
+		Buffer data doesn't have to start at the beginning of OpenGL buffer object,
+		for example when buffer storage is allocated from BufferArena.
+		\return Offset of buffer data in OpenGL buffer object in bytes.
+	*/
+	size_t getStorageOffset() const;
+
+	//! Get byte size.
+	/*!
+		\return Size of buffer data in bytes.
+	*/
+	size_t getByteSize() const;
+
+	//! Owns storage?
+	/*!
+		\return False if buffer uses range of shared OpenGL buffer object, e.g. from BufferArena.
+	*/
+	bool ownsStorage() const;
+
+	//! Get storage generation.
+	/*!
+		Generation changes whenever storage is reallocated or replaced and is never
+		shared by two storages, even if OpenGL reuses buffer object identifier.
+		\return Storage generation.
+	*/
+	unsigned int getStorageGeneration() const;
+
+	//! Is storage immutable?
+	/*!
+		\return True if storage was allocated by setStorage() and can't be reallocated.
+	*/
+	bool isImmutable() const;
+
+	//! Get storage flags.
+	/*!
+		When immutable storage isn't supported by graphics card, PERSISTENT and
+		COHERENT flags can't be satisfied and are not reported.
+		\return Storage flags in effect or StorageFlags::NONE if storage isn't immutable.
+	*/
+	unsigned int getStorageFlags() const;
+
+	//! Copy data from other buffer.
+	/*!
+		Copy data between buffers directly in graphics card memory without
+		transfering them to system memory. Buffer isn't reallocated, so
+		the destination range must fit into current size of buffer.
+		\param source Source buffer.
+		\param sourceOffset Offset in source buffer in bytes.
+		\param offset Offset in this buffer in bytes.
+		\param size Size of copied data in bytes.
+		\return True if data were copied successfully.
+	*/
+	bool copyFrom(const BufferBase& source, size_t sourceOffset, size_t offset, size_t size);
+
 	//! Get frequency mode.
 	/*! 
 		\return Frequency mode.
@@ -132,19 +236,31 @@ public:
 
 	//! Set frequency mode.
 	/*! 
-		New mode will be applied after next setData() call.
+		New mode will be applied after next setData() call. Has no effect on immutable storage,
+		except when it falls back to mutable storage, in which case mode set by user is kept.
 		\param frequencyMode Frequency mode.
 	*/
 	void setFrequencyMode(FrequencyMode frequencyMode);
 	
 	//! Set nature mode.
 	/*! 
-		New mode will be applied in next setData() call.
+		New mode will be applied in next setData() call. Has no effect on immutable storage,
+		except when it falls back to mutable storage, in which case mode set by user is kept.
 		\param natureMode Nature mode.
 	*/
 	void setNatureMode(NatureMode natureMode);
 
 protected:
+	//! Resolve range.
+	/*!
+		Check range against size of buffer and replace zero count with
+		number of elements remaining to the end of buffer.
+		\param range Range of elements.
+		\param elementSize Size of single element in bytes.
+		\return True if range lies within buffer.
+	*/
+	bool resolveRange(BufferRange& range, size_t elementSize) const;
+
 	//! Map buffer from graphics card memory to system memory.
 	/*!
 		\param mappedPtr Pointer to pointer to first index.
@@ -154,6 +270,29 @@ protected:
 	//! Unmap buffer from system memory
 	bool unmapBuffer() const;
 
+	//! Get part of buffer as plain data.
+	/*!
+		\param data Pointer to memory of at least size bytes.
+		\param offset Offset in buffer in bytes.
+		\param size Size of data in bytes.
+		\return True if data were copied successfully.
+	*/
+	bool getPlainSubData(void* data, size_t offset, size_t size) const;
+
+	//! Map range of buffer from graphics card memory to system memory.
+	/*!
+		Buffer isn't left bound after mapping.
+		\param mappedPtr Pointer to pointer to first byte of range.
+		\param offset Offset of range in bytes.
+		\param size Size of range in bytes.
+		\param access Map access flags.
+		\return True if mapped successfully.
+	*/
+	bool mapRange(void** mappedPtr, size_t offset, size_t size, unsigned int access) const;
+
+	//! Unmap range mapped by mapRange().
+	bool unmapRange() const;
+
 	//! Set buffer with plain data.
 	/*!
 		\param data Pointer to plain data.
@@ -162,11 +301,63 @@ protected:
 	*/
 	bool setPlainData(const void* data, size_t size);
 
+	//! Set part of buffer with plain data.
+	/*!
+		Storage isn't reallocated and no signal is sent.
+		\param data Pointer to plain data.
+		\param offset Offset in buffer in bytes.
+		\param size Size of plain data in bytes.
+		\return True if data were set successfully.
+	*/
+	bool setPlainSubData(const void* data, size_t offset, size_t size);
+
+	//! Set multiple parts of buffer with plain data.
+	/*!
+		Ranges are sorted and adjacent or overlapping ranges are merged,
+		so that the fewest possible upload commands are issued.
+		Storage isn't reallocated and no signal is sent.
+		\param data Pointer to plain data mirroring whole buffer.
+		\param ranges Ranges of elements to be set.
+		\param elementSize Size of single element in bytes.
+		\return True if data were set successfully.
+	*/
+	bool setPlainRanges(const void* data, std::vector<BufferRange> ranges, size_t elementSize);
+
+	//! Set buffer with immutable storage.
+	/*!
+		Storage allocated this way can't be resized or reallocated
+		for the whole lifetime of buffer. When immutable storage isn't
+		supported by graphics card, usage hint closest to flags is used instead.
+		\param data Pointer to plain data. Can be NULL.
+		\param size Size of storage in bytes.
+		\param flags Storage flags.
+		\return True if storage was allocated successfully.
+	*/
+	bool setPlainStorage(const void* data, size_t size, unsigned int flags);
+
+	//! Attach shared storage.
+	/*!
+		Use range of other OpenGL buffer object as storage of this buffer.
+		Storage owned by buffer is released. Buffer with shared storage
+		can't be reallocated by itself.
+		\param bufferID OpenGL buffer object identifier.
+		\param offset Offset of range in bytes.
+		\param size Size of range in bytes.
+	*/
+	void attachStorage(unsigned int bufferID, size_t offset, size_t size);
+
 	size_t m_byteSize;
+	bool m_immutable;
+	unsigned int m_storageFlags;
 private:
 	FrequencyMode m_frequencyMode;
 	NatureMode m_natureMode;
+	bool m_usageHintSet;
 	unsigned int m_bufferID;
+	size_t m_storageOffset;
+	bool m_ownsStorage;
+	unsigned int m_storageGeneration;
+	static unsigned int m_generationCounter;
 };
 
 //! Buffer class.
@@ -209,6 +400,67 @@ public:
 	*/
 	bool getDataCopy(T*& arr, unsigned int& size) const;
 
+	//! Get data.
+	/*!
+		Copies range of buffer data from graphics card memory to memory provided by caller.
+		\param arr Array storage for data. Array must be able to hold all elements of range.
+		\param range Range of elements to copy.
+		\return True if data were copied successfully.
+	*/
+	bool getData(T* arr, BufferRange range = BufferRange()) const;
+
+	//! Get data.
+	/*!
+		Copies range of buffer data from graphics card memory to memory provided by caller.
+		\param vec Vector storage for data. Vector isn't resized and must be able to hold all elements of range.
+		\param range Range of elements to copy.
+		\return True if data were copied successfully.
+	*/
+	bool getData(std::vector<T>& vec, BufferRange range = BufferRange()) const;
+
+	//! Stream data.
+	/*!
+		Pass range of buffer data to callback in chunks of fixed size. Each chunk
+		is mapped and passed in place, so no additional system memory is needed.
+		Callback receives pointer to chunk data, index of first element in chunk
+		and number of elements in chunk. If callback returns false, streaming stops.
+		\param callback Callback processing chunks.
+		\param chunkSize Maximal number of elements in single chunk.
+		\param range Range of elements to stream.
+		\return True if streaming finished or was stopped by callback, false if
+		range is invalid or chunk couldn't be mapped or unmapped.
+	*/
+	bool streamData(std::function<bool(const T*, unsigned int, unsigned int)> callback, unsigned int chunkSize, BufferRange range = BufferRange()) const;
+
+	//! Read data asynchronously.
+	/*!
+		Start copying range of data to staging buffer without waiting for
+		previously issued rendering to finish. Data can be retrieved from
+		returned readback once it is ready.
+		\param range Range of elements to read.
+		\return Readback or null pointer on failure.
+	*/
+	typename Readback<T>::Ptr readAsync(BufferRange range = BufferRange()) const;
+
+	//! Map range of data.
+	/*!
+		Map range of data to system memory and provide direct access to it.
+		Range stays mapped until returned view is destroyed.
+		\param range Range of elements to map.
+		\param access Map access flags (see BufferBase::MapAccess).
+		\return Mapped view. View isn't mapped on failure.
+	*/
+	MappedView<T> map(BufferRange range = BufferRange(), unsigned int access = MapAccess::READ);
+
+	//! Map range of data for reading.
+	/*!
+		Map range of data to system memory and provide read only access to it.
+		Range stays mapped until returned view is destroyed.
+		\param range Range of elements to map.
+		\return Read only mapped view. View isn't mapped on failure.
+	*/
+	MappedView<const T> map(BufferRange range = BufferRange()) const;
+
 	//! Get string.
 	/*! 
 		Convert values to string. Values are delimited by space.
@@ -233,6 +485,66 @@ public:
 		\return True if data were set successfully.
 	*/
 	bool setData(const T* arr, unsigned int size);
+
+	//! Set immutable storage.
+	/*!
+		Storage can't be resized, reallocated or cleared afterwards.
+		Contents can still be modified if DYNAMIC flag is set.
+		\param vec Vector with initial data.
+		\param flags Storage flags (see StorageFlags).
+		\return True if storage was allocated successfully.
+	*/
+	bool setStorage(const std::vector<T>& vec, unsigned int flags = StorageFlags::NONE);
+
+	//! Set immutable storage.
+	/*!
+		Storage can't be resized, reallocated or cleared afterwards.
+		Contents can still be modified if DYNAMIC flag is set.
+		\param arr Array with initial data. Can be NULL to leave storage uninitialized.
+		\param size Size of storage in elements.
+		\param flags Storage flags (see StorageFlags).
+		\return True if storage was allocated successfully.
+	*/
+	bool setStorage(const T* arr, unsigned int size, unsigned int flags = StorageFlags::NONE);
+
+	//! Set part of data.
+	/*!
+		Overwrite elements starting at offset without reallocating buffer.
+		\param offset Index of first element to overwrite.
+		\param vec Vector with data.
+		\return True if data were set successfully.
+	*/
+	bool setSubData(unsigned int offset, const std::vector<T>& vec);
+
+	//! Set part of data.
+	/*!
+		Overwrite elements starting at offset without reallocating buffer.
+		\param offset Index of first element to overwrite.
+		\param arr Array with data.
+		\param size Size of array in elements.
+		\return True if data were set successfully.
+	*/
+	bool setSubData(unsigned int offset, const T* arr, unsigned int size);
+
+	//! Set ranges of data.
+	/*!
+		Upload only modified (dirty) ranges of data without reallocating buffer.
+		Adjacent and overlapping ranges are merged into single upload.
+		\param vec Vector with data mirroring whole buffer.
+		\param ranges Ranges of elements to be uploaded.
+		\return True if data were set successfully.
+	*/
+	bool setRanges(const std::vector<T>& vec, const std::vector<BufferRange>& ranges);
+
+	//! Set ranges of data.
+	/*!
+		Upload only modified (dirty) ranges of data without reallocating buffer.
+		Adjacent and overlapping ranges are merged into single upload.
+		\param arr Array with data mirroring whole buffer.
+		\param ranges Ranges of elements to be uploaded.
+		\return True if data were set successfully.
+	*/
+	bool setRanges(const T* arr, const std::vector<BufferRange>& ranges);
 };
 
 UNISHADER_END
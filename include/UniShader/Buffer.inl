@@ -26,6 +26,7 @@
 #include <UniShader/Utility.h>
 #include <iostream>
 #include <sstream>
+#include <cstring>
 
 #include "Buffer.h"
 
@@ -123,6 +124,101 @@ bool Buffer<T>::getDataCopy(T*& arr, unsigned int& size) const{
 	return BufferBase::unmapBuffer();
 }
 
+template <typename T> 
+bool Buffer<T>::getData(T* arr, BufferRange range) const{
+	if(arr == 0){
+		std::cerr << "ERROR: Passed pointer is NULL" << std::endl;
+		return FAILURE;
+	}
+
+	if(!BufferBase::resolveRange(range, sizeof(T)))
+		return FAILURE;
+
+	return BufferBase::getPlainSubData(arr, sizeof(T)*range.offset, sizeof(T)*range.count);
+}
+
+template <typename T> 
+bool Buffer<T>::getData(std::vector<T>& vec, BufferRange range) const{
+	if(!BufferBase::resolveRange(range, sizeof(T)))
+		return FAILURE;
+
+	if(vec.size() < range.count){
+		std::cerr << "ERROR: Passed vector is too small" << std::endl;
+		return FAILURE;
+	}
+
+	return BufferBase::getPlainSubData(&vec[0], sizeof(T)*range.offset, sizeof(T)*range.count);
+}
+
+template <typename T> 
+bool Buffer<T>::streamData(std::function<bool(const T*, unsigned int, unsigned int)> callback, unsigned int chunkSize, BufferRange range) const{
+	if(chunkSize == 0){
+		std::cerr << "ERROR: Chunk size must be nonzero" << std::endl;
+		return FAILURE;
+	}
+
+	if(!BufferBase::resolveRange(range, sizeof(T)))
+		return FAILURE;
+
+	unsigned int end = range.offset + range.count;
+	for(unsigned int first = range.offset; first < end; first += chunkSize){
+		unsigned int count = end - first < chunkSize ? end - first : chunkSize;
+
+		MappedView<const T> chunk = map(BufferRange(first, count));
+		if(!chunk.isMapped())
+			return FAILURE;
+
+		//stopping on request of callback isn't an error, failing to unmap is
+		bool proceed = callback(chunk.data(), first, count);
+		if(!chunk.unmap())
+			return FAILURE;
+		if(!proceed)
+			return SUCCESS;
+	}
+
+	return SUCCESS;
+}
+
+template <typename T> 
+typename Readback<T>::Ptr Buffer<T>::readAsync(BufferRange range) const{
+	if(!BufferBase::resolveRange(range, sizeof(T)))
+		return 0;
+
+	typename Readback<T>::Ptr ptr(new Readback<T>);
+	if(!ptr->start(*this, sizeof(T)*range.offset, sizeof(T)*range.count))
+		return 0;
+
+	return ptr;
+}
+
+template <typename T> 
+MappedView<T> Buffer<T>::map(BufferRange range, unsigned int access){
+	if(!BufferBase::resolveRange(range, sizeof(T)))
+		return MappedView<T>();
+
+	void* mappedPtr = 0;
+	if(!BufferBase::mapRange(&mappedPtr, sizeof(T)*range.offset, sizeof(T)*range.count, access)){
+		std::cerr << "ERROR: Failed to access GPU memory" << std::endl;
+		return MappedView<T>();
+	}
+
+	return MappedView<T>(this, (T*)mappedPtr, range.count);
+}
+
+template <typename T> 
+MappedView<const T> Buffer<T>::map(BufferRange range) const{
+	if(!BufferBase::resolveRange(range, sizeof(T)))
+		return MappedView<const T>();
+
+	void* mappedPtr = 0;
+	if(!BufferBase::mapRange(&mappedPtr, sizeof(T)*range.offset, sizeof(T)*range.count, MapAccess::READ)){
+		std::cerr << "ERROR: Failed to access GPU memory" << std::endl;
+		return MappedView<const T>();
+	}
+
+	return MappedView<const T>(this, (const T*)mappedPtr, range.count);
+}
+
 template <typename T> 
 std::string Buffer<T>::getString(unsigned int begin, unsigned int count, const std::ios& format) const{
 	T* mappedPtr = 0;
@@ -183,4 +279,57 @@ bool Buffer<T>::setData(const T* arr, unsigned int size){
 		return FAILURE;
 }
 
+template <typename T> 
+bool Buffer<T>::setStorage(const std::vector<T>& vec, unsigned int flags){
+	if(vec.size() == 0){
+		std::cerr << "ERROR: Zero sized vector passed" << std::endl;
+		return FAILURE;
+	}
+	return BufferBase::setPlainStorage(&vec[0], sizeof(T)*vec.size(), flags);
+}
+
+template <typename T> 
+bool Buffer<T>::setStorage(const T* arr, unsigned int size, unsigned int flags){
+	if(size == 0){
+		std::cerr << "ERROR: Zero sized storage requested" << std::endl;
+		return FAILURE;
+	}
+	return BufferBase::setPlainStorage(arr, sizeof(T)*size, flags);
+}
+
+template <typename T> 
+bool Buffer<T>::setSubData(unsigned int offset, const std::vector<T>& vec){
+	if(vec.size() == 0)
+		return SUCCESS;
+	return BufferBase::setPlainSubData(&vec[0], sizeof(T)*offset, sizeof(T)*vec.size());
+}
+
+template <typename T> 
+bool Buffer<T>::setSubData(unsigned int offset, const T* arr, unsigned int size){
+	if(size == 0)
+		return SUCCESS;
+	return BufferBase::setPlainSubData(arr, sizeof(T)*offset, sizeof(T)*size);
+}
+
+template <typename T> 
+bool Buffer<T>::setRanges(const std::vector<T>& vec, const std::vector<BufferRange>& ranges){
+	if(vec.size()*sizeof(T) < m_byteSize){
+		std::cerr << "ERROR: Passed vector is smaller than buffer" << std::endl;
+		return FAILURE;
+	}
+	//buffer is empty too, so there is nothing any range could refer to
+	if(vec.empty()){
+		if(ranges.empty())
+			return SUCCESS;
+		std::cerr << "ERROR: Range exceeds size of buffer" << std::endl;
+		return FAILURE;
+	}
+	return BufferBase::setPlainRanges(&vec[0], ranges, sizeof(T));
+}
+
+template <typename T> 
+bool Buffer<T>::setRanges(const T* arr, const std::vector<BufferRange>& ranges){
+	return BufferBase::setPlainRanges(arr, ranges, sizeof(T));
+}
+
 UNISHADER_END
@@ -0,0 +1,139 @@
+/*
+* UniShader - Interface for GPGPU and working with shader programs
+* Copyright (c) 2011-2013 Ivan Sevcik - ivan-sevcik@hotmail.com
+*
+* This software is provided 'as-is', without any express or
+* implied warranty. In no event will the authors be held
+* liable for any damages arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute
+* it freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented;
+*    you must not claim that you wrote the original software.
+*    If you use this software in a product, an acknowledgment
+*    in the product documentation would be appreciated but
+*    is not required.
+*
+* 2. Altered source versions must be plainly marked as such,
+*    and must not be misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any
+*    source distribution.
+*/
+
+#pragma once
+#ifndef BUFFER_ARENA_H
+#define BUFFER_ARENA_H
+
+#include <UniShader/Config.h>
+#include <UniShader/Utility.h>
+#include <UniShader/ObjectBase.h>
+
+#include <memory>
+#include <string>
+#include <deque>
+#include <map>
+
+UNISHADER_BEGIN
+
+//! Buffer arena class.
+/*!
+	Buffer arena owns a few large buffer objects in graphics card memory
+	and sub-allocates aligned ranges from them. Using arena for many small
+	buffers avoids creating and reallocating separate buffer object for each
+	of them, which fragments driver memory.
+
+	Free ranges of each block are kept in free-list ordered by offset and
+	neighbouring free ranges are merged when range is released. Allocation
+	uses first range that is big enough. Allocations bigger than block size
+	get their own block.
+*/
+
+class UniShader_API BufferArena : public ObjectBase{
+private:
+	BufferArena(size_t blockSize, size_t alignment);
+public:
+	typedef std::shared_ptr<BufferArena> Ptr; //!< Shared pointer.
+	virtual const std::string& getClassName() const; //!< Get name of this class.
+	~BufferArena();
+
+	//! Allocation statistics.
+	class Statistics{
+	public:
+		Statistics();
+
+		unsigned int blockCount; //!< Number of buffer objects owned by arena.
+		unsigned int allocationCount; //!< Number of live allocations.
+		unsigned int totalAllocations; //!< Number of allocations made during arena lifetime.
+		unsigned int totalReleases; //!< Number of releases made during arena lifetime.
+		size_t reservedBytes; //!< Size of all buffer objects in bytes.
+		size_t allocatedBytes; //!< Size of all live allocations in bytes (including alignment).
+		size_t largestFreeRange; //!< Size of largest free range in bytes.
+	};
+
+	//! Create buffer arena.
+	/*!
+		\param blockSize Size of single buffer object in bytes.
+		\param alignment Alignment of allocated ranges in bytes. Must be power of two.
+		\return Buffer arena.
+	*/
+	static Ptr create(size_t blockSize = 16 << 20, size_t alignment = 256);
+
+	//! Allocate range.
+	/*!
+		\param size Size of range in bytes.
+		\param bufferID OpenGL identifier of buffer object containing range.
+		\param offset Offset of range in buffer object in bytes.
+		\return True if allocated successfully.
+	*/
+	bool allocate(size_t size, unsigned int& bufferID, size_t& offset);
+
+	//! Release range.
+	/*!
+		Return previously allocated range back to arena.
+		If the range wasn't allocated from this arena, function returns silently.
+		\param bufferID OpenGL identifier of buffer object containing range.
+		\param offset Offset of range in buffer object in bytes.
+	*/
+	void release(unsigned int bufferID, size_t offset);
+
+	//! Get block size.
+	/*!
+		\return Size of single buffer object in bytes.
+	*/
+	size_t getBlockSize() const;
+
+	//! Get alignment.
+	/*!
+		\return Alignment of allocated ranges in bytes.
+	*/
+	size_t getAlignment() const;
+
+	//! Get statistics.
+	/*!
+		\return Allocation statistics.
+	*/
+	Statistics getStatistics() const;
+private:
+	class Block{
+	public:
+		unsigned int bufferID;
+		size_t size;
+		std::map<size_t, size_t> freeRanges;
+		std::map<size_t, size_t> usedRanges;
+	};
+
+	bool addBlock(size_t size);
+
+	std::deque<Block> m_blocks;
+	size_t m_blockSize;
+	size_t m_alignment;
+	unsigned int m_totalAllocations;
+	unsigned int m_totalReleases;
+};
+
+UNISHADER_END
+
+#endif
@@ -0,0 +1,93 @@
+/*
+* UniShader - Interface for GPGPU and working with shader programs
+* Copyright (c) 2011-2013 Ivan Sevcik - ivan-sevcik@hotmail.com
+*
+* This software is provided 'as-is', without any express or
+* implied warranty. In no event will the authors be held
+* liable for any damages arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute
+* it freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented;
+*    you must not claim that you wrote the original software.
+*    If you use this software in a product, an acknowledgment
+*    in the product documentation would be appreciated but
+*    is not required.
+*
+* 2. Altered source versions must be plainly marked as such,
+*    and must not be misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any
+*    source distribution.
+*/
+
+#pragma once
+#ifndef FENCE_H
+#define FENCE_H
+
+#include <UniShader/Config.h>
+#include <UniShader/Utility.h>
+
+UNISHADER_BEGIN
+
+//! Fence class.
+/*!
+	Fence is synchronization object inserted into OpenGL command stream.
+	It becomes signaled once graphics card finishes all commands issued
+	before the fence, which allows application to find out whether
+	data used by these commands can be safely accessed without stalling.
+*/
+
+class UniShader_API Fence{
+public:
+	Fence();
+	~Fence();
+
+	//! Insert fence.
+	/*!
+		Insert fence after all previously issued OpenGL commands.
+		Command stream is flushed, so that polling isSignaled() eventually succeeds.
+		Fence inserted earlier is released.
+	*/
+	void insert();
+
+	//! Is fence set?
+	/*!
+		\return True if fence was inserted and not yet cleared.
+	*/
+	bool isSet() const;
+
+	//! Is fence signaled?
+	/*!
+		Check fence state without blocking.
+		Fence that isn't set is considered signaled.
+		\return True if all commands preceding the fence were finished.
+	*/
+	bool isSignaled();
+
+	//! Wait for fence.
+	/*!
+		Block until fence is signaled or timeout expires.
+		Fence that isn't set is considered signaled.
+		\param timeout Timeout in nanoseconds.
+		\return True if fence was signaled.
+	*/
+	bool wait(unsigned long long timeout = 1000000000ull);
+
+	//! Clear fence.
+	/*!
+		Release synchronization object.
+	*/
+	void clear();
+private:
+	Fence(const Fence&);
+	Fence& operator =(const Fence&);
+
+	void* m_sync;
+};
+
+UNISHADER_END
+
+#endif
@@ -0,0 +1,63 @@
+/*
+* UniShader - Interface for GPGPU and working with shader programs
+* Copyright (c) 2011-2013 Ivan Sevcik - ivan-sevcik@hotmail.com
+*
+* This software is provided 'as-is', without any express or
+* implied warranty. In no event will the authors be held
+* liable for any damages arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute
+* it freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented;
+*    you must not claim that you wrote the original software.
+*    If you use this software in a product, an acknowledgment
+*    in the product documentation would be appreciated but
+*    is not required.
+*
+* 2. Altered source versions must be plainly marked as such,
+*    and must not be misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any
+*    source distribution.
+*/
+
+#pragma once
+#ifndef INDIRECT_COMMAND_H
+#define INDIRECT_COMMAND_H
+
+#include <UniShader/Config.h>
+
+UNISHADER_BEGIN
+
+//! Indirect command for rendering arrays.
+/*!
+	Layout matches command read by glDrawArraysIndirect. Commands are stored in buffer
+	so that job lists can be built on CPU and uploaded, or written on graphics card
+	by other shader program.
+	\sa UniShader::renderIndirect()
+*/
+struct DrawArraysIndirectCommand{
+	unsigned int count; //!< Number of vertices.
+	unsigned int instanceCount; //!< Number of instances.
+	unsigned int first; //!< Index of first vertex.
+	unsigned int baseInstance; //!< Index of first instance. Must be zero without ARB_base_instance.
+};
+
+//! Indirect command for rendering elements.
+/*!
+	Layout matches command read by glDrawElementsIndirect.
+	\sa UniShader::renderElementsIndirect()
+*/
+struct DrawElementsIndirectCommand{
+	unsigned int count; //!< Number of elements.
+	unsigned int instanceCount; //!< Number of instances.
+	unsigned int firstIndex; //!< Index of first element in element buffer.
+	int baseVertex; //!< Value added to each element.
+	unsigned int baseInstance; //!< Index of first instance. Must be zero without ARB_base_instance.
+};
+
+UNISHADER_END
+
+#endif
@@ -34,14 +34,22 @@
 
 UNISHADER_BEGIN
 
+class BufferArena;
+
 //! Internal buffer class.
 /*!
 	Internal buffer class is inner class used by interface.
+	If arena is used, storage of internal buffer is sub-allocated from it.
+
+	Similarly to std::vector, logical size of internal buffer is separated
+	from capacity of its storage. Storage only grows when buffer is resized
+	beyond capacity, so changing size back and forth doesn't reallocate it.
+	Contents of buffer are not preserved when storage is reallocated.
 */
 
 class InternalBuffer : public BufferBase{
 private:
-	InternalBuffer();
+	InternalBuffer(std::shared_ptr<BufferArena> arena);
 public:
 	virtual const std::string& getClassName() const; //!< Get name of this class
 
@@ -49,9 +57,10 @@ public:
 
 	//! Create internal buffer.
 	/*!
+		\param arena Arena to allocate storage from. If null, buffer has its own storage.
 		\return Internal buffer.
 	*/
-	static Ptr create();
+	static Ptr create(std::shared_ptr<BufferArena> arena = std::shared_ptr<BufferArena>());
 
 	//! Get size.
 	/*!
@@ -59,11 +68,54 @@ public:
 	*/
 	size_t getSize() const;
 
+	//! Get capacity.
+	/*!
+		\return Size of allocated storage in bytes.
+	*/
+	size_t getCapacity() const;
+
+	//! Get growth factor.
+	/*!
+		\return Growth factor.
+	*/
+	float getGrowthFactor() const;
+
+	//! Set growth factor.
+	/*!
+		When buffer is resized beyond capacity, new capacity is the bigger of
+		new size and old capacity multiplied by growth factor.
+		\param factor Growth factor. Values smaller than 1 are treated as 1.
+	*/
+	void setGrowthFactor(float factor);
+
 	//! Resize buffer to new size.
 	/*!
+		Storage is reallocated only if size exceeds capacity. If reallocation
+		fails, buffer keeps its previous storage and size.
 		\param size New size of buffer in bytes.
+		\return True if storage was reallocated successfully or didn't need to be.
 	*/
-	void resize(size_t size);
+	bool resize(size_t size);
+
+	//! Reserve capacity.
+	/*!
+		Reallocate storage if capacity is smaller than requested.
+		\param capacity Minimal capacity in bytes.
+	*/
+	void reserve(size_t capacity);
+
+	//! Shrink to fit.
+	/*!
+		Reallocate storage so that capacity matches size. Storage allocated
+		from buffer arena is kept when size is zero, since range can't be empty.
+	*/
+	void shrinkToFit();
+private:
+	bool reallocate(size_t capacity);
+
+	std::shared_ptr<BufferArena> m_arena;
+	size_t m_capacity;
+	float m_growthFactor;
 };
 
 UNISHADER_END
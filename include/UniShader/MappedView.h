@@ -0,0 +1,115 @@
+/*
+* UniShader - Interface for GPGPU and working with shader programs
+* Copyright (c) 2011-2013 Ivan Sevcik - ivan-sevcik@hotmail.com
+*
+* This software is provided 'as-is', without any express or
+* implied warranty. In no event will the authors be held
+* liable for any damages arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute
+* it freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented;
+*    you must not claim that you wrote the original software.
+*    If you use this software in a product, an acknowledgment
+*    in the product documentation would be appreciated but
+*    is not required.
+*
+* 2. Altered source versions must be plainly marked as such,
+*    and must not be misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any
+*    source distribution.
+*/
+
+#pragma once
+#ifndef MAPPED_VIEW_H
+#define MAPPED_VIEW_H
+
+#include <UniShader/Config.h>
+#include <UniShader/Utility.h>
+
+#include <cstddef>
+#include <type_traits>
+
+UNISHADER_BEGIN
+
+template <typename T> class Buffer;
+
+//! Mapped view class.
+/*!
+	Mapped view provides direct access to range of buffer data mapped from
+	graphics card memory to system memory. Data are accessed in place without
+	being copied. Range is unmapped when view is destroyed.
+
+	Buffer must not be used by OpenGL or mapped again while view exists.
+	View must not outlive buffer it was created from. View of constant
+	buffer has constant element type and is read only.
+*/
+
+template <typename T>
+class MappedView{
+	typedef Buffer<typename std::remove_const<T>::type> BufferType;
+	friend class Buffer<typename std::remove_const<T>::type>;
+private:
+	MappedView(const BufferType* buffer, T* data, unsigned int size);
+	MappedView(const MappedView& ref);
+	MappedView& operator =(const MappedView& ref);
+public:
+	typedef T* iterator; //!< Iterator.
+	typedef const T* const_iterator; //!< Constant iterator.
+
+	MappedView();
+	MappedView(MappedView&& ref);
+	MappedView& operator =(MappedView&& ref);
+	~MappedView();
+
+	//! Is mapped?
+	/*!
+		\return True if view holds mapped range.
+	*/
+	bool isMapped() const;
+
+	//! Get size.
+	/*!
+		\return Number of elements in view.
+	*/
+	unsigned int size() const;
+
+	//! Get data.
+	/*!
+		\return Pointer to first element.
+	*/
+	T* data() const;
+
+	//! Get iterator to first element.
+	iterator begin() const;
+
+	//! Get iterator past last element.
+	iterator end() const;
+
+	//! Access element.
+	/*!
+		\param index Index of element relative to start of view.
+		\return Reference to element.
+	*/
+	T& operator [](unsigned int index) const;
+
+	//! Unmap.
+	/*!
+		Unmap range before view is destroyed.
+		\return True if unmapped successfully.
+	*/
+	bool unmap();
+private:
+	const BufferType* m_buffer;
+	T* m_data;
+	unsigned int m_size;
+};
+
+UNISHADER_END
+
+#include <UniShader/MappedView.inl>
+
+#endif
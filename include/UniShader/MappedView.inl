@@ -0,0 +1,117 @@
+/*
+* UniShader - Interface for GPGPU and working with shader programs
+* Copyright (c) 2011-2013 Ivan Sevcik - ivan-sevcik@hotmail.com
+*
+* This software is provided 'as-is', without any express or
+* implied warranty. In no event will the authors be held
+* liable for any damages arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute
+* it freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented;
+*    you must not claim that you wrote the original software.
+*    If you use this software in a product, an acknowledgment
+*    in the product documentation would be appreciated but
+*    is not required.
+*
+* 2. Altered source versions must be plainly marked as such,
+*    and must not be misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any
+*    source distribution.
+*/
+
+#include <UniShader/Utility.h>
+
+UNISHADER_BEGIN
+
+template <typename T> 
+MappedView<T>::MappedView():
+m_buffer(0),
+m_data(0),
+m_size(0){
+
+}
+
+template <typename T> 
+MappedView<T>::MappedView(const BufferType* buffer, T* data, unsigned int size):
+m_buffer(buffer),
+m_data(data),
+m_size(size){
+
+}
+
+template <typename T> 
+MappedView<T>::MappedView(MappedView&& ref):
+m_buffer(ref.m_buffer),
+m_data(ref.m_data),
+m_size(ref.m_size){
+	ref.m_buffer = 0;
+	ref.m_data = 0;
+	ref.m_size = 0;
+}
+
+template <typename T> 
+MappedView<T>& MappedView<T>::operator =(MappedView&& ref){
+	if(this != &ref){
+		unmap();
+		m_buffer = ref.m_buffer;
+		m_data = ref.m_data;
+		m_size = ref.m_size;
+		ref.m_buffer = 0;
+		ref.m_data = 0;
+		ref.m_size = 0;
+	}
+	return *this;
+}
+
+template <typename T> 
+MappedView<T>::~MappedView(){
+	unmap();
+}
+
+template <typename T> 
+bool MappedView<T>::isMapped() const{
+	return m_buffer != 0;
+}
+
+template <typename T> 
+unsigned int MappedView<T>::size() const{
+	return m_size;
+}
+
+template <typename T> 
+T* MappedView<T>::data() const{
+	return m_data;
+}
+
+template <typename T> 
+typename MappedView<T>::iterator MappedView<T>::begin() const{
+	return m_data;
+}
+
+template <typename T> 
+typename MappedView<T>::iterator MappedView<T>::end() const{
+	return m_data + m_size;
+}
+
+template <typename T> 
+T& MappedView<T>::operator [](unsigned int index) const{
+	return m_data[index];
+}
+
+template <typename T> 
+bool MappedView<T>::unmap(){
+	if(!m_buffer)
+		return SUCCESS;
+
+	bool result = m_buffer->unmapRange();
+	m_buffer = 0;
+	m_data = 0;
+	m_size = 0;
+	return result;
+}
+
+UNISHADER_END
@@ -0,0 +1,109 @@
+/*
+* UniShader - Interface for GPGPU and working with shader programs
+* Copyright (c) 2011-2013 Ivan Sevcik - ivan-sevcik@hotmail.com
+*
+* This software is provided 'as-is', without any express or
+* implied warranty. In no event will the authors be held
+* liable for any damages arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute
+* it freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented;
+*    you must not claim that you wrote the original software.
+*    If you use this software in a product, an acknowledgment
+*    in the product documentation would be appreciated but
+*    is not required.
+*
+* 2. Altered source versions must be plainly marked as such,
+*    and must not be misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any
+*    source distribution.
+*/
+
+#pragma once
+#ifndef PING_PONG_H
+#define PING_PONG_H
+
+#include <UniShader/Config.h>
+#include <UniShader/Utility.h>
+#include <UniShader/ObjectBase.h>
+#include <UniShader/SafePtr.h>
+#include <UniShader/Buffer.h>
+#include <UniShader/Attribute.h>
+#include <UniShader/Varying.h>
+
+#include <memory>
+#include <string>
+
+UNISHADER_BEGIN
+
+//! Ping pong class.
+/*!
+	Ping pong holds pair of buffers used for iterative computations where output
+	of one pass is input of next pass. Source buffer is read by attribute and
+	target buffer is written by varying. After each pass buffers are swapped
+	so data never leave graphics card memory.
+*/
+
+template <typename T>
+class PingPong : public ObjectBase{
+private:
+	PingPong(typename Buffer<T>::Ptr first, typename Buffer<T>::Ptr second);
+public:
+	typedef std::shared_ptr<PingPong<T>> Ptr; //!< Shared pointer.
+	virtual const std::string& getClassName() const; //!< Get name of this class.
+	~PingPong();
+
+	//! Create ping pong.
+	/*!
+		\param first Buffer that is source in first pass.
+		\param second Buffer that is target in first pass.
+		\return Pointer to ping pong.
+	*/
+	static Ptr create(typename Buffer<T>::Ptr first, typename Buffer<T>::Ptr second);
+
+	//! Connect attribute and varying.
+	/*!
+		Attribute reads from source buffer and varying records into target buffer.
+		Offset and stride of attribute are kept.
+		\param attribute Attribute reading source buffer.
+		\param varying Varying writing target buffer.
+	*/
+	void connect(Attribute::Ptr attribute, Varying::Ptr varying);
+
+	//! Swap buffers.
+	/*!
+		Target becomes source and vice versa. Connected attribute and varying
+		are reconnected without changing vertex array layout.
+	*/
+	void swap();
+
+	//! Get source buffer.
+	/*!
+		\return Buffer read in next pass.
+	*/
+	typename Buffer<T>::Ptr getSource() const;
+
+	//! Get target buffer.
+	/*!
+		\return Buffer written in next pass.
+	*/
+	typename Buffer<T>::Ptr getTarget() const;
+
+private:
+	void reconnect();
+
+	typename Buffer<T>::Ptr m_source;
+	typename Buffer<T>::Ptr m_target;
+	Attribute::Ptr m_attribute;
+	Varying::Ptr m_varying;
+};
+
+UNISHADER_END
+
+#include <UniShader/PingPong.inl>
+
+#endif
@@ -0,0 +1,89 @@
+/*
+* UniShader - Interface for GPGPU and working with shader programs
+* Copyright (c) 2011-2013 Ivan Sevcik - ivan-sevcik@hotmail.com
+*
+* This software is provided 'as-is', without any express or
+* implied warranty. In no event will the authors be held
+* liable for any damages arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute
+* it freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented;
+*    you must not claim that you wrote the original software.
+*    If you use this software in a product, an acknowledgment
+*    in the product documentation would be appreciated but
+*    is not required.
+*
+* 2. Altered source versions must be plainly marked as such,
+*    and must not be misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any
+*    source distribution.
+*/
+
+#include <UniShader/Utility.h>
+#include <iostream>
+
+UNISHADER_BEGIN
+
+template <typename T>
+PingPong<T>::PingPong(typename Buffer<T>::Ptr first, typename Buffer<T>::Ptr second):
+m_source(first),
+m_target(second){
+
+}
+
+template <typename T>
+const std::string& PingPong<T>::getClassName() const{
+	static const std::string name("us::PingPong");
+	return name;
+}
+
+template <typename T>
+PingPong<T>::~PingPong(){
+
+}
+
+template <typename T>
+typename PingPong<T>::Ptr PingPong<T>::create(typename Buffer<T>::Ptr first, typename Buffer<T>::Ptr second){
+	if(!first || !second || first == second){
+		std::cerr << "ERROR: Ping pong requires two different buffers" << std::endl;
+		return Ptr();
+	}
+	return Ptr(new PingPong<T>(first, second));
+}
+
+template <typename T>
+void PingPong<T>::connect(Attribute::Ptr attribute, Varying::Ptr varying){
+	m_attribute = attribute;
+	m_varying = varying;
+	reconnect();
+}
+
+template <typename T>
+void PingPong<T>::swap(){
+	std::swap(m_source, m_target);
+	reconnect();
+}
+
+template <typename T>
+typename Buffer<T>::Ptr PingPong<T>::getSource() const{
+	return m_source;
+}
+
+template <typename T>
+typename Buffer<T>::Ptr PingPong<T>::getTarget() const{
+	return m_target;
+}
+
+template <typename T>
+void PingPong<T>::reconnect(){
+	if(m_attribute)
+		m_attribute->connectBuffer(m_source, m_attribute->getBufferOffset(), m_attribute->getBufferStride());
+	if(m_varying)
+		m_varying->connectBuffer(m_target);
+}
+
+UNISHADER_END
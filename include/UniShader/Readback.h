@@ -0,0 +1,152 @@
+/*
+* UniShader - Interface for GPGPU and working with shader programs
+* Copyright (c) 2011-2013 Ivan Sevcik - ivan-sevcik@hotmail.com
+*
+* This software is provided 'as-is', without any express or
+* implied warranty. In no event will the authors be held
+* liable for any damages arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute
+* it freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented;
+*    you must not claim that you wrote the original software.
+*    If you use this software in a product, an acknowledgment
+*    in the product documentation would be appreciated but
+*    is not required.
+*
+* 2. Altered source versions must be plainly marked as such,
+*    and must not be misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any
+*    source distribution.
+*/
+
+#pragma once
+#ifndef READBACK_H
+#define READBACK_H
+
+#include <UniShader/Config.h>
+#include <UniShader/Utility.h>
+#include <UniShader/ObjectBase.h>
+#include <UniShader/Fence.h>
+
+#include <memory>
+#include <vector>
+#include <string>
+
+UNISHADER_BEGIN
+
+class BufferBase;
+template <typename T> class Buffer;
+
+//! Readback base class.
+/*!
+	Readback base stores staging buffer that holds copy of buffer data
+	on their way from graphics card memory to system memory.
+*/
+
+class UniShader_API ReadbackBase : public ObjectBase{
+protected:
+	ReadbackBase();
+public:
+	typedef std::shared_ptr<ReadbackBase> Ptr; //!< Shared pointer.
+	virtual const std::string& getClassName() const; //!< Get name of this class.
+	~ReadbackBase();
+
+	//! Is ready?
+	/*!
+		Check without blocking whether data were already copied to staging buffer.
+		Copy is flushed when readback starts, so it's safe to poll this once per frame
+		until it succeeds.
+		\return True if data can be retrieved without waiting.
+	*/
+	bool isReady();
+
+	//! Wait.
+	/*!
+		Block until data are copied to staging buffer or timeout expires.
+		\param timeout Timeout in nanoseconds.
+		\return True if data are ready.
+	*/
+	bool wait(unsigned long long timeout = 1000000000ull);
+
+	//! Get byte size.
+	/*!
+		\return Size of read data in bytes.
+	*/
+	size_t getByteSize() const;
+
+protected:
+	//! Start readback.
+	/*!
+		Issue copy of data from source buffer to staging buffer and fence it.
+		\param source Source buffer.
+		\param offset Offset in source buffer in bytes.
+		\param size Size of data in bytes.
+		\return True if readback was started successfully.
+	*/
+	bool start(const BufferBase& source, size_t offset, size_t size);
+
+	//! Copy plain data.
+	/*!
+		Wait for readback to finish and copy data from staging buffer.
+		\param data Pointer to memory of at least getByteSize() bytes.
+		\return True if data were copied successfully.
+	*/
+	bool copyPlainData(void* data);
+
+private:
+	Fence m_fence;
+	unsigned int m_stagingID;
+	size_t m_byteSize;
+};
+
+//! Readback class.
+/*!
+	Readback is handle of asynchronous transfer of buffer data from graphics
+	card memory to system memory. It is returned by Buffer::readAsync(). Data are
+	first copied to staging buffer on graphics card without stalling application
+	and can be retrieved once the copy finishes. This allows multiple renderings
+	to be in flight while results of earlier ones are being retrieved.
+*/
+
+template <typename T>
+class Readback : public ReadbackBase{
+	friend class Buffer<T>;
+private:
+	Readback();
+public:
+	typedef std::shared_ptr<Readback<T>> Ptr; //!< Shared pointer.
+	virtual const std::string& getClassName() const; //!< Get name of this class.
+	~Readback();
+
+	//! Get size.
+	/*!
+		\return Number of read elements.
+	*/
+	unsigned int getSize() const;
+
+	//! Get data.
+	/*!
+		Waits for readback to finish if data aren't ready yet.
+		\param vec Vector storage for data. Vector is resized to fit data.
+		\return True if data were copied successfully.
+	*/
+	bool getData(std::vector<T>& vec);
+
+	//! Get data.
+	/*!
+		Waits for readback to finish if data aren't ready yet.
+		\param arr Array storage for data. Array must be able to hold getSize() elements.
+		\return True if data were copied successfully.
+	*/
+	bool getData(T* arr);
+};
+
+UNISHADER_END
+
+#include <UniShader/Readback.inl>
+
+#endif
@@ -0,0 +1,78 @@
+/*
+* UniShader - Interface for GPGPU and working with shader programs
+* Copyright (c) 2011-2013 Ivan Sevcik - ivan-sevcik@hotmail.com
+*
+* This software is provided 'as-is', without any express or
+* implied warranty. In no event will the authors be held
+* liable for any damages arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute
+* it freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented;
+*    you must not claim that you wrote the original software.
+*    If you use this software in a product, an acknowledgment
+*    in the product documentation would be appreciated but
+*    is not required.
+*
+* 2. Altered source versions must be plainly marked as such,
+*    and must not be misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any
+*    source distribution.
+*/
+
+#include <UniShader/Utility.h>
+#include <iostream>
+
+UNISHADER_BEGIN
+
+template <typename T> 
+Readback<T>::Readback(){
+
+}
+
+template <typename T>
+const std::string& Readback<T>::getClassName() const{
+	static const std::string name("us::Readback");
+	return name;
+}
+
+template <typename T> 
+Readback<T>::~Readback(){
+
+}
+
+template <typename T> 
+unsigned int Readback<T>::getSize() const{
+	return getByteSize()/sizeof(T);
+}
+
+template <typename T> 
+bool Readback<T>::getData(std::vector<T>& vec){
+	try{
+		vec.resize(getSize());
+	}
+	catch(...){
+		std::cerr << "ERROR: Failed to allocate memory for data" << std::endl;
+		vec.clear();
+		return FAILURE;
+	}
+
+	if(vec.size() == 0)
+		return SUCCESS;
+
+	return ReadbackBase::copyPlainData(&vec[0]);
+}
+
+template <typename T> 
+bool Readback<T>::getData(T* arr){
+	if(arr == 0){
+		std::cerr << "ERROR: Passed pointer is NULL" << std::endl;
+		return FAILURE;
+	}
+	return ReadbackBase::copyPlainData(arr);
+}
+
+UNISHADER_END
@@ -119,6 +119,9 @@ public:
 	//! Prepare.
 	/*!
 		Prepare input and underlying classes for use.
+		Only attributes that changed are applied. With ARB_multi_bind sources of all
+		attributes are bound with single glBindVertexBuffers call, so swapping
+		input data set doesn't touch vertex format.
 		\return True if prepared successfully.
 	*/
 	void prepare();
@@ -129,6 +132,15 @@ public:
 	*/
 	void activate();
 
+	//! Refresh active input.
+	/*!
+		Used when input was left active between renderings. Changed attributes are
+		applied into bound VAO. Uniforms and textures are kept as they are unless
+		some uniform changed, in which case input is activated again.
+		\return Estimated number of OpenGL calls skipped thanks to kept state, zero if input was activated again.
+	*/
+	unsigned int refresh();
+
 	//! Is active?
 	/*!
 		Return if shader input is active.
@@ -150,11 +162,14 @@ public:
 	*/
 	virtual bool handleSignal(unsigned int signalID, const ObjectBase* callerPtr);
 private:	
+	void bindSources();
+
 	ShaderProgram& m_program;
 	std::deque< std::shared_ptr<Attribute> > m_attribs;
 	std::deque< std::shared_ptr<Uniform> > m_uniforms;
 	unsigned int m_VAO;
 	bool m_remakeVAO;
+	bool m_useMultiBind;
 	bool m_active;
 };
 
@@ -43,6 +43,7 @@ UNISHADER_BEGIN
 class ShaderProgram;
 class Varying;
 class BufferBase;
+class BufferArena;
 template <typename T> class Buffer;
 
 //! Shader output class.
@@ -51,6 +52,7 @@ template <typename T> class Buffer;
 */
 
 class UniShader_API ShaderOutput : public SignalSender, public ObjectBase{
+	friend class Varying;
 public:
 	ShaderOutput(ShaderProgram& program);
 	typedef SafePtr<ShaderOutput> Ptr; //!< Safe pointer
@@ -66,7 +68,8 @@ public:
 	public:
 		enum Types{	CHANGED, //!< Class changed its state.
 					INTERLEAVED, //!< Output was set to interleaved mode
-					DEINTERLEAVED //!< Output was set to deinterleaved mode
+					DEINTERLEAVED, //!< Output was set to deinterleaved mode
+					ARENA_CHANGED //!< Arena used for output buffers was changed
 		}; 
 	};
 
@@ -74,6 +77,10 @@ public:
 	/*!
 		Create and add new varying to shader output.
 		If varying with same name already exists, pointer to that varying is returned.
+		In interleaved mode names gl_SkipComponents1 to gl_SkipComponents4 can be used
+		to leave gaps of 1 to 4 floats in recorded data, each of them can be added repeatedly.
+		Name gl_NextBuffer doesn't create varying and null pointer is returned, varyings added
+		after it are recorded to next buffer, same as with setVaryingBuffer().
 		\param name Name of varying.
 		\return Pointer to varying.
 	*/
@@ -101,6 +108,9 @@ public:
 		If shader output is interleaved, all values are recorded to single buffer.
 		In interleaved mode all underlying varyings return this buffer. 
 		In deinterleaved (separate) mode each varying has it own buffer and values are split between them.
+		When ARB_transform_feedback3 is supported, separate mode is recorded as interleaved capture with
+		each varying followed by gl_NextBuffer. Memory layout is the same, but varyings aren't limited
+		by GL_MAX_TRANSFORM_FEEDBACK_SEPARATE_COMPONENTS, so matrices can be recorded as well.
 	*/
 	void interleave(bool interl);
 
@@ -117,7 +127,91 @@ public:
 		If output is not interlraved, null pointer is returned and error is generated.
 		\return Buffer.
 	*/
-	template <typename T> typename std::shared_ptr<const Buffer<T>> getInterleavedBuffer();
+	template <typename T> typename std::shared_ptr<const Buffer<T>> getInterleavedBuffer(unsigned int buffer = 0);
+
+	//! Set varying buffer.
+	/*!
+		Assign varying to one of buffers in interleaved mode. Varyings assigned to the
+		same buffer are interleaved, varyings in different buffers are separated.
+		This allows to mix interleaved and separate layout and to split output of
+		multiple vertex streams into different buffers. Using more than one buffer
+		requires ARB_transform_feedback3. Buffer indices should be contiguous.
+		This will affect next shader program linkage.
+		\param name Name of varying.
+		\param buffer Index of buffer.
+		\return True if varying exists.
+	*/
+	bool setVaryingBuffer(std::string name, unsigned int buffer);
+
+	//! Get buffer count.
+	/*!
+		\return Number of buffers recorded to.
+	*/
+	unsigned int getBufferCount();
+
+	//! Set stream count.
+	/*!
+		Set number of geometry shader vertex streams whose primitives are counted.
+		Stream of each varying is given by its declaration in geometry shader.
+		More than one stream requires ARB_transform_feedback3.
+		\param count Number of streams.
+	*/
+	void setStreamCount(unsigned int count);
+
+	//! Get stream count.
+	/*!
+		\return Number of vertex streams.
+	*/
+	unsigned int getStreamCount();
+
+	//! Set arena.
+	/*!
+		Allocate storage of output buffers from arena instead of creating
+		separate buffer object for each of them. Output buffers are recreated,
+		so previously recorded data are lost.
+		\param arena Buffer arena. If null, output buffers have their own storage.
+	*/
+	void setArena(std::shared_ptr<BufferArena> arena);
+
+	//! Get arena.
+	/*!
+		\return Arena used for output buffers or null pointer if none is used.
+	*/
+	std::shared_ptr<BufferArena> getArena();
+
+	//! Set growth factor.
+	/*!
+		Output buffers are reallocated only when they need to grow. New capacity is
+		the bigger of required size and old capacity multiplied by growth factor.
+		\param factor Growth factor. Values smaller than 1 are treated as 1.
+	*/
+	void setGrowthFactor(float factor);
+
+	//! Get growth factor.
+	/*!
+		\return Growth factor.
+	*/
+	float getGrowthFactor();
+
+	//! Reserve.
+	/*!
+		Make output buffers big enough to record given number of primitives
+		without reallocation. Takes effect in next prepare().
+		\param primitiveCount Number of primitives.
+	*/
+	void reserve(unsigned int primitiveCount);
+
+	//! Get reserved primitive count.
+	/*!
+		\return Number of primitives reserved by reserve().
+	*/
+	unsigned int getReservedCount();
+
+	//! Shrink to fit.
+	/*!
+		Release unused capacity of output buffers and cancel reservation.
+	*/
+	void shrinkToFit();
 
 	//! Set up.
 	/*!
@@ -147,22 +241,160 @@ public:
 	*/
 	bool isActive();
 
+	//! Pause.
+	/*!
+		Temporarily stop recording without ending it. Rendering done while output
+		is paused isn't recorded. Requires ARB_transform_feedback2.
+		\return True if paused successfully.
+	*/
+	bool pause();
+
+	//! Resume.
+	/*!
+		Continue recording stopped by pause(). New values are appended after
+		previously recorded ones.
+		\return True if resumed successfully.
+	*/
+	bool resume();
+
+	//! Is paused?
+	/*!
+		\return True if output is active, but paused.
+	*/
+	bool isPaused();
+
 	//! Deactivate.
 	/*!
 		Return OpenGL context states modified by this class to their default state.
 	*/
 	void deactivate();
+
+	//! Get OpenGL transform feedback identifier.
+	/*!
+		Transform feedback object is created on first recording.
+		\return Numeric identifier of transform feedback object or 0 if there's none.
+	*/
+	unsigned int getFeedbackGlID();
+
+	//! Get number of primitives written.
+	/*!
+		Result of last recorded rendering is retrieved lazily, so recording doesn't
+		stall application while graphics card is still working. Without waiting,
+		function fails if result isn't availible yet.
+		\param count Number of primitives written by last recorded rendering.
+		\param wait Block until result is availible.
+		\param stream Vertex stream.
+		\return True if result is availible.
+	*/
+	bool getPrimitivesWritten(unsigned int& count, bool wait = false, unsigned int stream = 0);
+
+	//! Get number of primitives generated.
+	/*!
+		Counts all primitives generated by last recorded rendering, including
+		those that didn't fit into output buffers. Primitives generated while
+		output was paused aren't counted. Result is retrieved lazily.
+		\param count Number of primitives generated by last recorded rendering.
+		\param wait Block until result is availible.
+		\param stream Vertex stream.
+		\return True if result is availible.
+	*/
+	bool getPrimitivesGenerated(unsigned int& count, bool wait = false, unsigned int stream = 0);
+
+	//! Has overflowed?
+	/*!
+		Check if last recorded rendering generated more primitives than output buffers
+		could hold. Primitives that didn't fit were dropped. Rendering done while
+		output was paused isn't taken into account.
+		\param overflow True if any stream overflowed.
+		\param wait Block until result is availible.
+		\return True if result is availible.
+	*/
+	bool hasOverflowed(bool& overflow, bool wait = false);
+
+	//! Set maximal outputs per primitive.
+	/*!
+		Output buffers are sized for given number of outputs per each rendered primitive.
+		Geometry shaders that amplify geometry need value bigger than 1.
+		\param count Maximal number of outputs per primitive. Zero is treated as 1.
+	*/
+	void setMaxOutputsPerPrimitive(unsigned int count);
+
+	//! Get maximal outputs per primitive.
+	/*!
+		\return Maximal number of outputs per primitive.
+	*/
+	unsigned int getMaxOutputsPerPrimitive();
+
+	//! Set auto grow.
+	/*!
+		If enabled, UniShader waits for recorded rendering to finish and if output
+		overflowed, it increases maximal outputs per primitive and renders again.
+		This allows to size output buffers tightly for amplifying shaders at the cost
+		of synchronization after each rendering. Rendering must be repeatable.
+		\param autoGrow True to enable.
+	*/
+	void setAutoGrow(bool autoGrow);
+
+	//! Is auto grow enabled?
+	/*!
+		\return True if enabled.
+	*/
+	bool isAutoGrow();
+
+	//! Get query object count.
+	/*!
+		Query objects are recycled between renderings, so the count
+		stays constant for repeated renderings.
+		\return Number of OpenGL query objects owned by output.
+	*/
+	unsigned int getQueryObjectCount();
 private:
+	class FeedbackBinding{
+	public:
+		FeedbackBinding(unsigned int buffer = 0, unsigned int gen = 0, size_t off = 0, size_t sz = 0):bufferID(buffer),generation(gen),offset(off),size(sz){}
+		bool operator ==(const FeedbackBinding& ref) const{ return bufferID == ref.bufferID && generation == ref.generation && offset == ref.offset && size == ref.size; }
+		bool operator !=(const FeedbackBinding& ref) const{ return !(*this == ref); }
+
+		unsigned int bufferID;
+		unsigned int generation;
+		size_t offset;
+		size_t size;
+	};
+
+	void updateBindings();
+	void resizeInterleavedBuffers(unsigned int count);
+	void beginGeneratedQueries();
+	void endGeneratedQueries();
+	bool getQueryResult(unsigned int index, unsigned int& count, bool wait);
+	unsigned int acquireQuery();
+	void releaseQuery(unsigned int query);
+
 	ShaderProgram& m_program;
 	std::deque< std::shared_ptr<Varying> > m_varyings;
 	std::vector<const char*> m_names;
-	std::shared_ptr<BufferBase> m_interleavedBuffer;
-	size_t m_overallSize;
-	unsigned int m_query;
-	int m_primitivesProcessed;
+	std::vector< std::shared_ptr<BufferBase> > m_interleavedBuffers;
+	std::shared_ptr<BufferArena> m_arena;
+	std::vector<size_t> m_recordSizes;
+	float m_growthFactor;
+	unsigned int m_reservedCount;
+	unsigned int m_maxOutputs;
+	bool m_autoGrow;
+	unsigned int m_feedbackID;
+	std::vector<FeedbackBinding> m_bindings;
+	std::vector<unsigned int> m_freeQueries;
+	unsigned int m_queryCount;
+	unsigned int m_streamCount;
+	unsigned int m_queryStreamCount;
+	unsigned int m_addBufferIndex;
+	int m_maxSeparateComponents;
+	std::vector<unsigned int> m_queries;
+	std::vector<unsigned int> m_pendingQueries;
+	std::vector<unsigned int> m_queryResults;
 	bool m_interleaved;
+	bool m_separateByBuffers;
 	bool m_prepared;
 	bool m_active;
+	bool m_paused;
 };
 
 UNISHADER_END
@@ -29,9 +29,14 @@
 UNISHADER_BEGIN
 
 template <typename T>
-typename std::shared_ptr<const Buffer<T>> ShaderOutput::getInterleavedBuffer(){
-	if(m_interleaved)
-		return std::static_pointer_cast<const Buffer<T>>(m_interleavedBuffer);
+typename std::shared_ptr<const Buffer<T>> ShaderOutput::getInterleavedBuffer(unsigned int buffer){
+	if(m_interleaved){
+		if(buffer >= m_interleavedBuffers.size()){
+			std::cerr << "ERROR: Buffer index out of range" << std::endl;
+			return 0;
+		}
+		return std::static_pointer_cast<const Buffer<T>>(m_interleavedBuffers[buffer]);
+	}
 	else{
 		std::cerr << "ERROR: Output isn't set to interleaved mode" << std::endl;
 		return 0;
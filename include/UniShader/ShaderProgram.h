@@ -36,6 +36,7 @@
 
 #include <memory>
 #include <deque>
+#include <map>
 
 UNISHADER_BEGIN
 
@@ -99,6 +100,16 @@ public:
 	};
 
 
+	//! Activation statistics.
+	class Statistics{
+	public:
+		Statistics();
+
+		unsigned int activations; //!< Number of activations.
+		unsigned int boundActivations; //!< Number of activations that reused state kept bound by previous deactivation.
+		unsigned int estimatedCallsSkipped; //!< Estimated number of OpenGL calls that full deactivation and activation would issue, but were skipped thanks to kept state. Based on typical number of calls per kept binding, not on counting issued calls.
+	};
+
 	//! Create shader program.
 	/*!
 		\return Shader program.
@@ -165,7 +176,8 @@ public:
 		Activate program by modifying OpenGL context. Also prepare underlying classes for use.
 		\param primitiveType Primitive type that will be recorded.
 		\param primitiveCount Number of primitives that will be recorded.
-		\return True if program was activated successfully.
+		\return True if program was activated successfully. Fails if output can't hold
+		recorded primitives, e.g. when buffer connected to varying is too small.
 	*/
 	bool activate(PrimitiveType primitiveType, unsigned int primitiveCount);
 
@@ -176,12 +188,56 @@ public:
 	*/
 	bool isActive();
 
+	//! Update active program.
+	/*!
+		Apply changes of input (attributes, uniforms) made while program is active,
+		without interrupting recording of output.
+		\return True if program is active and input was updated.
+	*/
+	bool update();
+
 	//! Deactivate.
 	/*!
 		Return OpenGL context states modified by this class to their default state.
 	*/
 	bool deactivate();
 
+	//! Set keep bound mode.
+	/*!
+		In keep bound mode deactivation leaves program, VAO and texture units bound,
+		only recording of output is finished. Next activation of the same program then
+		applies only attributes and uniforms that changed instead of binding everything
+		again, so back-to-back renderings don't pay for full activation. State is released
+		when other program is activated, program is relinked or keep bound mode is disabled.
+		Kept state is tracked for each OpenGL context separately (GLEW_MX), release must be
+		called with the context the program was used in being current.
+		\param keepBound True to enable keep bound mode.
+		\sa getStatistics()
+	*/
+	void setKeepBound(bool keepBound);
+
+	//! Is keep bound mode enabled?
+	/*!
+		\return True if enabled.
+	*/
+	bool isKeepBound();
+
+	//! Release kept state.
+	/*!
+		Return OpenGL context states left bound in keep bound mode to their default state.
+		Does nothing while program is active.
+	*/
+	void release();
+
+	//! Get activation statistics.
+	/*!
+		\return Statistics accumulated since creation or last resetStatistics().
+	*/
+	Statistics getStatistics() const;
+
+	//! Reset activation statistics.
+	void resetStatistics();
+
 	//! Handle incoming signal.
 	/*!
 		\param signalID Signal identifier.
@@ -192,6 +248,11 @@ public:
 private:
 	bool link();
 	int printProgramInfoLog() const;
+	bool activateBound();
+	bool useProgram();
+	void unbind();
+	static const void* getCurrentContext();
+	static ShaderProgram*& boundProgram();
    
 	std::shared_ptr<ShaderInput> m_input;
 	std::shared_ptr<ShaderOutput> m_output;
@@ -199,6 +260,11 @@ private:
 	unsigned int m_programObjectID;
 	LinkStatus m_linkStatus;
 	bool m_active;
+	bool m_keepBound;
+	bool m_bound;
+	Statistics m_statistics;
+	const void* m_boundContext;
+	static std::map<const void*, ShaderProgram*> m_boundPrograms;
 };
 
 UNISHADER_END
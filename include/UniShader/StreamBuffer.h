@@ -0,0 +1,141 @@
+/*
+* UniShader - Interface for GPGPU and working with shader programs
+* Copyright (c) 2011-2013 Ivan Sevcik - ivan-sevcik@hotmail.com
+*
+* This software is provided 'as-is', without any express or
+* implied warranty. In no event will the authors be held
+* liable for any damages arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute
+* it freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented;
+*    you must not claim that you wrote the original software.
+*    If you use this software in a product, an acknowledgment
+*    in the product documentation would be appreciated but
+*    is not required.
+*
+* 2. Altered source versions must be plainly marked as such,
+*    and must not be misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any
+*    source distribution.
+*/
+
+#pragma once
+#ifndef STREAM_BUFFER_H
+#define STREAM_BUFFER_H
+
+#include <UniShader/Config.h>
+#include <UniShader/Utility.h>
+#include <UniShader/ObjectBase.h>
+#include <UniShader/Buffer.h>
+
+UNISHADER_BEGIN
+
+class Fence;
+
+//! Stream buffer class.
+/*!
+	Stream buffer is intended for data that are uploaded anew for every
+	rendering. Its storage is allocated only once and split into several
+	regions that are used in round-robin fashion. While graphics card reads
+	one region, application can already write next one. Each region is
+	guarded by fence so that it isn't overwritten before previous rendering
+	using it finishes.
+
+	If immutable storage is supported, buffer is persistently mapped and
+	regions are written directly. Otherwise each region is mapped when acquired
+	and unmapped when released.
+
+	Usage for every rendering is: acquireRegion(), write data, releaseRegion(),
+	render. Attributes should be connected to stream buffer with zero offset and
+	getRegionElementOffset() should be passed as rendering offset, so that
+	switching regions doesn't modify attributes and vertex array isn't rebuilt.
+*/
+
+class UniShader_API StreamBuffer : public BufferBase{
+private:
+	StreamBuffer();
+public:
+	typedef std::shared_ptr<StreamBuffer> Ptr; //!< Shared pointer.
+	virtual const std::string& getClassName() const; //!< Get name of this class.
+	~StreamBuffer();
+
+	//! Create stream buffer.
+	/*!
+		\param regionSize Size of single region in bytes. It should be multiple of element size.
+		\param regionCount Number of regions.
+		\return Stream buffer.
+	*/
+	static Ptr create(size_t regionSize, unsigned int regionCount = 3);
+
+	//! Acquire region.
+	/*!
+		Advance to next region and return pointer to its memory. If graphics
+		card still uses the region, function waits until it is released.
+		Previously acquired region is fenced so all rendering commands using
+		it must be issued before this call.
+		\return Pointer to writable memory of region or NULL on failure.
+	*/
+	void* acquireRegion();
+
+	//! Release region.
+	/*!
+		Make data written to current region availible to graphics card.
+		Must be called before the region is used for rendering.
+		\return True if released successfully.
+	*/
+	bool releaseRegion();
+
+	//! Get region index.
+	/*!
+		\return Index of current region.
+	*/
+	unsigned int getRegionIndex() const;
+
+	//! Get region count.
+	/*!
+		\return Number of regions.
+	*/
+	unsigned int getRegionCount() const;
+
+	//! Get region size.
+	/*!
+		\return Size of single region in bytes.
+	*/
+	size_t getRegionSize() const;
+
+	//! Get region offset.
+	/*!
+		\return Offset of current region from the beginning of buffer in bytes.
+	*/
+	size_t getRegionOffset() const;
+
+	//! Get region element offset.
+	/*!
+		\param elementSize Size of single element (vertex) in bytes.
+		\return Index of first element in current region.
+	*/
+	unsigned int getRegionElementOffset(size_t elementSize) const;
+
+	//! Is persistent?
+	/*!
+		\return True if buffer is persistently mapped.
+	*/
+	bool isPersistent() const;
+private:
+	bool allocate(size_t regionSize, unsigned int regionCount);
+
+	Fence* m_fences;
+	char* m_persistentPtr;
+	size_t m_regionSize;
+	unsigned int m_regionCount;
+	unsigned int m_regionIndex;
+	bool m_acquired;
+};
+
+UNISHADER_END
+
+#endif
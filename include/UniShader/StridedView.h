@@ -0,0 +1,142 @@
+/*
+* UniShader - Interface for GPGPU and working with shader programs
+* Copyright (c) 2011-2013 Ivan Sevcik - ivan-sevcik@hotmail.com
+*
+* This software is provided 'as-is', without any express or
+* implied warranty. In no event will the authors be held
+* liable for any damages arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute
+* it freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented;
+*    you must not claim that you wrote the original software.
+*    If you use this software in a product, an acknowledgment
+*    in the product documentation would be appreciated but
+*    is not required.
+*
+* 2. Altered source versions must be plainly marked as such,
+*    and must not be misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any
+*    source distribution.
+*/
+
+#pragma once
+#ifndef STRIDED_VIEW_H
+#define STRIDED_VIEW_H
+
+#include <UniShader/Config.h>
+#include <UniShader/Utility.h>
+#include <UniShader/MappedView.h>
+
+#include <cstddef>
+#include <vector>
+
+UNISHADER_BEGIN
+
+class Varying;
+
+//! Strided view class.
+/*!
+	Strided view provides typed access to values of single varying stored in
+	mapped buffer together with other values, for example in interleaved
+	transform feedback buffer. Consecutive values are separated by stride bytes.
+	Data are accessed in place and buffer is unmapped when view is destroyed.
+
+	Same restrictions as for MappedView apply.
+*/
+
+template <typename T>
+class StridedView{
+	friend class Varying;
+private:
+	StridedView(MappedView<char>&& mapped, size_t offset, size_t stride, unsigned int size);
+	StridedView(const StridedView& ref);
+	StridedView& operator =(const StridedView& ref);
+public:
+	//! Strided iterator.
+	class iterator{
+	public:
+		iterator(char* ptr = 0, size_t stride = 0):m_ptr(ptr),m_stride(stride){}
+		T& operator *() const{ return *(T*)m_ptr; }
+		T* operator ->() const{ return (T*)m_ptr; }
+		iterator& operator ++(){ m_ptr += m_stride; return *this; }
+		iterator operator ++(int){ iterator it(*this); m_ptr += m_stride; return it; }
+		bool operator ==(const iterator& ref) const{ return m_ptr == ref.m_ptr; }
+		bool operator !=(const iterator& ref) const{ return m_ptr != ref.m_ptr; }
+	private:
+		char* m_ptr;
+		size_t m_stride;
+	};
+
+	StridedView();
+	StridedView(StridedView&& ref);
+	StridedView& operator =(StridedView&& ref);
+
+	//! Is mapped?
+	/*!
+		\return True if view holds mapped range.
+	*/
+	bool isMapped() const;
+
+	//! Get size.
+	/*!
+		\return Number of elements in view.
+	*/
+	unsigned int size() const;
+
+	//! Get stride.
+	/*!
+		\return Distance between consecutive elements in bytes.
+	*/
+	size_t stride() const;
+
+	//! Get iterator to first element.
+	iterator begin() const;
+
+	//! Get iterator past last element.
+	iterator end() const;
+
+	//! Access element.
+	/*!
+		\param index Index of element relative to start of view.
+		\return Reference to element.
+	*/
+	T& operator [](unsigned int index) const;
+
+	//! Deinterleave.
+	/*!
+		Copy elements into contiguous memory.
+		\param arr Array storage for elements. Array must be able to hold size() elements.
+		\return True if elements were copied successfully.
+	*/
+	bool deinterleave(T* arr) const;
+
+	//! Deinterleave.
+	/*!
+		Copy elements into contiguous memory.
+		\param vec Vector storage for elements. Vector is resized to fit elements.
+		\return True if elements were copied successfully.
+	*/
+	bool deinterleave(std::vector<T>& vec) const;
+
+	//! Unmap.
+	/*!
+		Unmap range before view is destroyed.
+		\return True if unmapped successfully.
+	*/
+	bool unmap();
+private:
+	MappedView<char> m_mapped;
+	char* m_first;
+	size_t m_stride;
+	unsigned int m_size;
+};
+
+UNISHADER_END
+
+#include <UniShader/StridedView.inl>
+
+#endif
@@ -0,0 +1,152 @@
+/*
+* UniShader - Interface for GPGPU and working with shader programs
+* Copyright (c) 2011-2013 Ivan Sevcik - ivan-sevcik@hotmail.com
+*
+* This software is provided 'as-is', without any express or
+* implied warranty. In no event will the authors be held
+* liable for any damages arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute
+* it freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented;
+*    you must not claim that you wrote the original software.
+*    If you use this software in a product, an acknowledgment
+*    in the product documentation would be appreciated but
+*    is not required.
+*
+* 2. Altered source versions must be plainly marked as such,
+*    and must not be misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any
+*    source distribution.
+*/
+
+#include <UniShader/Utility.h>
+#include <iostream>
+#include <cstring>
+
+UNISHADER_BEGIN
+
+template <typename T> 
+StridedView<T>::StridedView():
+m_first(0),
+m_stride(0),
+m_size(0){
+
+}
+
+template <typename T> 
+StridedView<T>::StridedView(MappedView<char>&& mapped, size_t offset, size_t stride, unsigned int size):
+m_mapped(std::move(mapped)),
+m_first(m_mapped.data() + offset),
+m_stride(stride),
+m_size(size){
+
+}
+
+template <typename T> 
+StridedView<T>::StridedView(StridedView&& ref):
+m_mapped(std::move(ref.m_mapped)),
+m_first(ref.m_first),
+m_stride(ref.m_stride),
+m_size(ref.m_size){
+	ref.m_first = 0;
+	ref.m_stride = 0;
+	ref.m_size = 0;
+}
+
+template <typename T> 
+StridedView<T>& StridedView<T>::operator =(StridedView&& ref){
+	if(this != &ref){
+		m_mapped = std::move(ref.m_mapped);
+		m_first = ref.m_first;
+		m_stride = ref.m_stride;
+		m_size = ref.m_size;
+		ref.m_first = 0;
+		ref.m_stride = 0;
+		ref.m_size = 0;
+	}
+	return *this;
+}
+
+template <typename T> 
+bool StridedView<T>::isMapped() const{
+	return m_mapped.isMapped();
+}
+
+template <typename T> 
+unsigned int StridedView<T>::size() const{
+	return m_size;
+}
+
+template <typename T> 
+size_t StridedView<T>::stride() const{
+	return m_stride;
+}
+
+template <typename T> 
+typename StridedView<T>::iterator StridedView<T>::begin() const{
+	return iterator(m_first, m_stride);
+}
+
+template <typename T> 
+typename StridedView<T>::iterator StridedView<T>::end() const{
+	return iterator(m_first + m_size*m_stride, m_stride);
+}
+
+template <typename T> 
+T& StridedView<T>::operator [](unsigned int index) const{
+	return *(T*)(m_first + index*m_stride);
+}
+
+template <typename T> 
+bool StridedView<T>::deinterleave(T* arr) const{
+	if(arr == 0){
+		std::cerr << "ERROR: Passed pointer is NULL" << std::endl;
+		return FAILURE;
+	}
+	if(!isMapped()){
+		std::cerr << "ERROR: View isn't mapped" << std::endl;
+		return FAILURE;
+	}
+
+	//tightly packed data can be copied at once
+	if(m_stride == sizeof(T)){
+		memcpy(arr, m_first, m_size*sizeof(T));
+		return SUCCESS;
+	}
+
+	const char* src = m_first;
+	for(unsigned int i = 0; i < m_size; i++, src += m_stride)
+		memcpy(arr + i, src, sizeof(T));
+	return SUCCESS;
+}
+
+template <typename T> 
+bool StridedView<T>::deinterleave(std::vector<T>& vec) const{
+	try{
+		vec.resize(m_size);
+	}
+	catch(...){
+		std::cerr << "ERROR: Failed to allocate memory for data" << std::endl;
+		vec.clear();
+		return FAILURE;
+	}
+
+	if(vec.size() == 0)
+		return SUCCESS;
+
+	return deinterleave(&vec[0]);
+}
+
+template <typename T> 
+bool StridedView<T>::unmap(){
+	m_first = 0;
+	m_stride = 0;
+	m_size = 0;
+	return m_mapped.unmap();
+}
+
+UNISHADER_END
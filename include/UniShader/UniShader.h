@@ -35,15 +35,22 @@
 #include <UniShader/ShaderInput.h>
 #include <UniShader/ShaderOutput.h>
 #include <UniShader/Buffer.h>
+#include <UniShader/StreamBuffer.h>
+#include <UniShader/BufferArena.h>
+#include <UniShader/Fence.h>
+#include <UniShader/IndirectCommand.h>
+#include <UniShader/UploadBatch.h>
 #include <UniShader/Attribute.h>
 #include <UniShader/Uniform.h>
 #include <UniShader/Varying.h>
+#include <UniShader/PingPong.h>
 #include <UniShader/Texture.h>
 #include <UniShader/TextureBuffer.h>
 #include <UniShader/PrimitiveType.h>
 
 #include <memory>
 #include <string>
+#include <vector>
 
 #ifdef GLEW_MX
 struct GLEWContextStruct;
@@ -77,6 +84,47 @@ public:
 	//! Disconnect program.
 	void disconnectProgram();
 
+	//! Set compute only mode.
+	/*!
+		In compute only mode rasterization is discarded during rendering, so no
+		fragments are generated and fragment stage isn't executed. Only recorded
+		output is produced. Use for pure GPGPU passes, program doesn't need
+		fragment shader in this case.
+		\param computeOnly True to enable compute only mode.
+	*/
+	void setComputeOnly(bool computeOnly);
+
+	//! Is compute only mode enabled?
+	/*!
+		\return True if enabled.
+	*/
+	bool isComputeOnly();
+
+	//! Begin recording.
+	/*!
+		Start recording session. All renderings until endRecording() is called are
+		recorded one after another into the same output buffers, regardless of their
+		offsets or element buffers. Output is paused between renderings and input changes
+		are applied before each of them. Rendering with record set to false isn't recorded.
+		\param primitiveType Primitive type that will be recorded. Must match all renderings in session.
+		\param capacity Number of primitives output buffers must be able to hold.
+		\return True if recording started successfully.
+	*/
+	bool beginRecording(PrimitiveType primitiveType, unsigned int capacity);
+
+	//! Is recording?
+	/*!
+		\return True if recording session is in progress.
+	*/
+	bool isRecording();
+
+	//! End recording.
+	/*!
+		Finish recording session. Waits until graphics card finishes recording.
+		\return Total number of primitives written during session.
+	*/
+	unsigned int endRecording();
+
 	//! Render.
 	/*!
 		Render array with OpenGL glDrawArrays command using ShaderProgram.
@@ -88,6 +136,24 @@ public:
 	*/
 	void render(PrimitiveType primitiveType, unsigned int primitiveCount, unsigned int offset = 0, bool record = true, bool wait = false);
 
+	//! Render instanced.
+	/*!
+		Render array multiple times with OpenGL glDrawArraysInstanced command using ShaderProgram.
+		Attributes with divisor set advance per instance, so per-batch parameters can be
+		broadcast to all elements without duplicating them. Output of all instances is
+		recorded one after another, buffers are sized for primitiveCount * instanceCount primitives.
+		Requires OpenGL 3.1 or ARB_draw_instanced.
+		\param primitiveType Primitive type that will be rendered.
+		\param primitiveCount Number of primitives that will be rendered in each instance.
+		\param instanceCount Number of instances.
+		\param baseInstance Index of first instance used for attributes with divisor. Non-zero value requires ARB_base_instance.
+		\param offset Global offset for all inputs.
+		\param record If true, shader output will be recorded and stored
+		\param wait If true, function won't return until all OpenGL commands haven't been processed.
+		\sa Attribute::setDivisor()
+	*/
+	void renderInstanced(PrimitiveType primitiveType, unsigned int primitiveCount, unsigned int instanceCount, unsigned int baseInstance = 0, unsigned int offset = 0, bool record = true, bool wait = false);
+
 	//! Render elements.
 	/*!
 		Render elements with OpenGL glDrawRangeElements command using ShaderProgram.
@@ -100,11 +166,83 @@ public:
 	*/
 	void renderElements(Buffer<unsigned int>::Ptr elementsBuffer, PrimitiveType primitiveType, unsigned int primitiveCount, unsigned int offset = 0, bool record = true, bool wait = false);
 
+	//! Render multiple ranges.
+	/*!
+		Render multiple ranges of arrays with single OpenGL glMultiDrawArrays command using ShaderProgram.
+		Program is activated only once for all ranges. Outputs of all ranges are recorded one after
+		another in order of ranges; shader can use gl_DrawIDARB (ARB_shader_draw_parameters) to tell them apart.
+		\param primitiveType Primitive type that will be rendered.
+		\param firsts Index of first vertex of each range.
+		\param counts Number of vertices of each range. Must have the same size as firsts.
+		\param record If true, shader output will be recorded and stored
+		\param wait If true, function won't return until all OpenGL commands haven't been processed.
+		\return True if ranges were valid and rendered without error.
+	*/
+	bool renderMulti(PrimitiveType primitiveType, const std::vector<int>& firsts, const std::vector<int>& counts, bool record = true, bool wait = false);
+
+	//! Render indirect.
+	/*!
+		Render arrays described by commands stored in buffer with OpenGL glMultiDrawArraysIndirect command
+		using ShaderProgram. Commands can be written by other shader program, so job lists built on graphics
+		card are submitted without reading them back. Without ARB_multi_draw_indirect each command is issued
+		with glDrawArraysIndirect. Outputs of all commands are recorded one after another in order of commands.
+		\param commands Buffer with commands.
+		\param primitiveType Primitive type that will be rendered.
+		\param drawCount Number of commands that will be rendered.
+		\param capacity Number of primitives output buffers must be able to hold when recording.
+		\param commandOffset Index of first command in buffer.
+		\param record If true, shader output will be recorded and stored
+		\param wait If true, function won't return until all OpenGL commands haven't been processed.
+		\return True if commands lie within command buffer and were rendered without error.
+	*/
+	bool renderIndirect(Buffer<DrawArraysIndirectCommand>::Ptr commands, PrimitiveType primitiveType, unsigned int drawCount, unsigned int capacity, unsigned int commandOffset = 0, bool record = true, bool wait = false);
+
+	//! Render elements indirect.
+	/*!
+		Render elements described by commands stored in buffer with OpenGL glMultiDrawElementsIndirect
+		command using ShaderProgram. Without ARB_multi_draw_indirect each command is issued with
+		glDrawElementsIndirect.
+		\param elementsBuffer Buffer of indices to be rendered.
+		\param commands Buffer with commands.
+		\param primitiveType Primitive type that will be rendered.
+		\param drawCount Number of commands that will be rendered.
+		\param capacity Number of primitives output buffers must be able to hold when recording.
+		\param commandOffset Index of first command in buffer.
+		\param record If true, shader output will be recorded and stored
+		\param wait If true, function won't return until all OpenGL commands haven't been processed.
+		\return True if commands lie within command buffer and were rendered without error.
+	*/
+	bool renderElementsIndirect(Buffer<unsigned int>::Ptr elementsBuffer, Buffer<DrawElementsIndirectCommand>::Ptr commands, PrimitiveType primitiveType, unsigned int drawCount, unsigned int capacity, unsigned int commandOffset = 0, bool record = true, bool wait = false);
+
+	//! Render feedback.
+	/*!
+		Render vertices recorded by other shader output with OpenGL glDrawTransformFeedback command
+		using ShaderProgram. Number of vertices is taken directly from graphics card memory,
+		so passes with variable number of outputs can be chained without reading results back.
+		Recorded buffers must be connected to attributes of this program.
+		\param source Shader output that recorded vertices. Must be different from output of this program.
+		\param primitiveType Primitive type that will be rendered.
+		\param capacity Number of primitives output buffers of this program must be able to hold when recording.
+		\param stream Vertex stream of source output that will be rendered.
+		\param record If true, shader output will be recorded and stored
+		\param wait If true, function won't return until all OpenGL commands haven't been processed.
+	*/
+	void renderFeedback(ShaderOutput::Ptr source, PrimitiveType primitiveType, unsigned int capacity, unsigned int stream = 0, bool record = true, bool wait = false);
+
 #ifdef GLEW_MX
     static void setGLEWContext(GLEWContextStruct* context);
 #endif
 private:
+	static bool getDrawMode(PrimitiveType primitiveType, unsigned int& mode);
+	static bool checkCommandRange(size_t bufferSize, size_t commandSize, unsigned int drawCount, unsigned int commandOffset);
+	bool beginDraw(PrimitiveType primitiveType, unsigned int primitiveCount, bool record);
+	void endDraw(bool record);
+	bool shouldRerun(unsigned int attempt);
+
 	ShaderProgram::Ptr m_program;
+	bool m_recording;
+	bool m_canPause;
+	bool m_computeOnly;
 };
 
 UNISHADER_END
@@ -182,6 +182,19 @@ public:
 	*/
 	void apply();
 
+	//! Needs apply?
+	/*!
+		\return True if source or settings changed since last apply().
+	*/
+	bool needsApply() const;
+
+	//! Estimate rebind call count.
+	/*!
+		\return Typical number of OpenGL calls issued when already applied uniform is
+		applied again and its texture source is deactivated afterwards.
+	*/
+	unsigned int estimateRebindCallCount() const;
+
 	//! Deactivate active texture source.
 	/*!
 		Applying uniform with a texture source activates the texture.
@@ -0,0 +1,173 @@
+/*
+* UniShader - Interface for GPGPU and working with shader programs
+* Copyright (c) 2011-2013 Ivan Sevcik - ivan-sevcik@hotmail.com
+*
+* This software is provided 'as-is', without any express or
+* implied warranty. In no event will the authors be held
+* liable for any damages arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute
+* it freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented;
+*    you must not claim that you wrote the original software.
+*    If you use this software in a product, an acknowledgment
+*    in the product documentation would be appreciated but
+*    is not required.
+*
+* 2. Altered source versions must be plainly marked as such,
+*    and must not be misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any
+*    source distribution.
+*/
+
+#pragma once
+#ifndef UPLOAD_BATCH_H
+#define UPLOAD_BATCH_H
+
+#include <UniShader/Config.h>
+#include <UniShader/Utility.h>
+#include <UniShader/ObjectBase.h>
+#include <UniShader/Buffer.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+UNISHADER_BEGIN
+
+//! Upload batch class.
+/*!
+	Upload batch collects data for many buffers and uploads them together.
+	Pending data are copied into single staging buffer with one map and then
+	distributed to destination buffers by copy commands executed in graphics
+	card memory. This is considerably cheaper than separate setData() call for
+	each of many small buffers.
+
+	Destination buffers whose size differs from uploaded data still have to be
+	reallocated separately, so batching pays off most when sizes are stable.
+*/
+
+class UniShader_API UploadBatch : public ObjectBase{
+private:
+	UploadBatch();
+public:
+	typedef std::shared_ptr<UploadBatch> Ptr; //!< Shared pointer.
+	virtual const std::string& getClassName() const; //!< Get name of this class.
+	~UploadBatch();
+
+	//! Upload statistics.
+	class Statistics{
+	public:
+		Statistics();
+
+		unsigned int flushCount; //!< Number of flushes.
+		unsigned int uploadCount; //!< Number of uploads flushed.
+		size_t uploadedBytes; //!< Size of flushed data in bytes.
+		size_t bytesSaved; //!< Size of data that weren't uploaded because they were overwritten before flush.
+		unsigned int callsIssued; //!< Number of OpenGL calls issued by flushes.
+		unsigned int callsSaved; //!< Number of OpenGL calls saved compared to separate uploads.
+	};
+
+	//! Create upload batch.
+	/*!
+		\return Upload batch.
+	*/
+	static Ptr create();
+
+	//! Set data.
+	/*!
+		Buffer is resized to fit data on flush. Pending uploads to the same
+		buffer are discarded.
+		\param buffer Destination buffer.
+		\param vec Vector with data. Data are copied immediately.
+		\return True if upload was added successfully.
+	*/
+	template <typename T> bool setData(std::shared_ptr< Buffer<T> > buffer, const std::vector<T>& vec);
+
+	//! Set data.
+	/*!
+		Buffer is resized to fit data on flush. Pending uploads to the same
+		buffer are discarded.
+		\param buffer Destination buffer.
+		\param arr Array with data. Data are copied immediately.
+		\param size Size of array in elements.
+		\return True if upload was added successfully.
+	*/
+	template <typename T> bool setData(std::shared_ptr< Buffer<T> > buffer, const T* arr, unsigned int size);
+
+	//! Set part of data.
+	/*!
+		Buffer isn't resized, data must fit into buffer at time of flush.
+		\param buffer Destination buffer.
+		\param offset Index of first element to be set.
+		\param vec Vector with data. Data are copied immediately.
+		\return True if upload was added successfully.
+	*/
+	template <typename T> bool setSubData(std::shared_ptr< Buffer<T> > buffer, unsigned int offset, const std::vector<T>& vec);
+
+	//! Set part of data.
+	/*!
+		Buffer isn't resized, data must fit into buffer at time of flush.
+		\param buffer Destination buffer.
+		\param offset Index of first element to be set.
+		\param arr Array with data. Data are copied immediately.
+		\param size Size of array in elements.
+		\return True if upload was added successfully.
+	*/
+	template <typename T> bool setSubData(std::shared_ptr< Buffer<T> > buffer, unsigned int offset, const T* arr, unsigned int size);
+
+	//! Flush.
+	/*!
+		Upload all pending data to their buffers.
+		\return True if all data were uploaded successfully.
+	*/
+	bool flush();
+
+	//! Discard pending uploads.
+	void discard();
+
+	//! Get pending upload count.
+	/*!
+		\return Number of uploads waiting for flush.
+	*/
+	unsigned int getPendingCount() const;
+
+	//! Get pending bytes.
+	/*!
+		\return Size of data waiting for flush in bytes.
+	*/
+	size_t getPendingBytes() const;
+
+	//! Get statistics.
+	/*!
+		\return Upload statistics accumulated over lifetime of batch.
+	*/
+	Statistics getStatistics() const;
+private:
+	class Upload{
+	public:
+		BufferBase::Ptr buffer;
+		size_t dataOffset;
+		size_t offset;
+		size_t size;
+		bool resize;
+	};
+
+	bool addPlainData(BufferBase::Ptr buffer, const void* data, size_t offset, size_t size, bool resize);
+	void compactData();
+
+	std::vector<Upload> m_uploads;
+	std::vector<char> m_data;
+	unsigned int m_stagingID;
+	size_t m_stagingSize;
+	Statistics m_statistics;
+};
+
+UNISHADER_END
+
+#include <UniShader/UploadBatch.inl>
+
+#endif
@@ -0,0 +1,63 @@
+/*
+* UniShader - Interface for GPGPU and working with shader programs
+* Copyright (c) 2011-2013 Ivan Sevcik - ivan-sevcik@hotmail.com
+*
+* This software is provided 'as-is', without any express or
+* implied warranty. In no event will the authors be held
+* liable for any damages arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute
+* it freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented;
+*    you must not claim that you wrote the original software.
+*    If you use this software in a product, an acknowledgment
+*    in the product documentation would be appreciated but
+*    is not required.
+*
+* 2. Altered source versions must be plainly marked as such,
+*    and must not be misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any
+*    source distribution.
+*/
+
+#include <UniShader/Utility.h>
+#include <iostream>
+
+UNISHADER_BEGIN
+
+template <typename T>
+bool UploadBatch::setData(std::shared_ptr< Buffer<T> > buffer, const std::vector<T>& vec){
+	if(vec.size() == 0){
+		std::cerr << "ERROR: Zero sized vector passed, use 'clear' to clear data" << std::endl;
+		return FAILURE;
+	}
+	return addPlainData(buffer, &vec[0], 0, sizeof(T)*vec.size(), true);
+}
+
+template <typename T>
+bool UploadBatch::setData(std::shared_ptr< Buffer<T> > buffer, const T* arr, unsigned int size){
+	if(size == 0){
+		std::cerr << "ERROR: Zero sized array passed, use 'clear' to clear data" << std::endl;
+		return FAILURE;
+	}
+	return addPlainData(buffer, arr, 0, sizeof(T)*size, true);
+}
+
+template <typename T>
+bool UploadBatch::setSubData(std::shared_ptr< Buffer<T> > buffer, unsigned int offset, const std::vector<T>& vec){
+	if(vec.size() == 0)
+		return SUCCESS;
+	return addPlainData(buffer, &vec[0], sizeof(T)*offset, sizeof(T)*vec.size(), false);
+}
+
+template <typename T>
+bool UploadBatch::setSubData(std::shared_ptr< Buffer<T> > buffer, unsigned int offset, const T* arr, unsigned int size){
+	if(size == 0)
+		return SUCCESS;
+	return addPlainData(buffer, arr, sizeof(T)*offset, sizeof(T)*size, false);
+}
+
+UNISHADER_END
@@ -33,6 +33,8 @@
 #include <UniShader/SafePtr.h>
 #include <UniShader/Signal.h>
 #include <UniShader/GLSLType.h>
+#include <UniShader/Buffer.h>
+#include <UniShader/StridedView.h>
 
 #include <memory>
 #include <string>
@@ -60,6 +62,7 @@ template <typename T> class Buffer;
 */
 
 class UniShader_API Varying : public SignalReceiver, public ObjectBase{
+	friend class ShaderOutput;
 public:
 	Varying(ShaderProgram& program, ShaderOutput& output, std::string name);
 	typedef SafePtr<Varying> Ptr; //!< Safe pointer.
@@ -73,6 +76,60 @@ public:
 	*/
 	template <typename T> typename std::shared_ptr<const Buffer<T>> getBuffer();
 
+	//! Get view.
+	/*!
+		Map buffer and return typed view of values of this varying. In interleaved
+		mode view skips values of other varyings, so no strides have to be computed
+		by hand. Availible after output was prepared. Size of T must match size of
+		single value of varying.
+		\param access Map access flags (see BufferBase::MapAccess).
+		\return Strided view. View isn't mapped if mapping failed.
+	*/
+	template <typename T> StridedView<T> view(unsigned int access = BufferBase::MapAccess::READ);
+
+	//! Connect buffer to varying and record values into it.
+	/*!
+		Only availible in separate (deinterleaved) mode. Buffer isn't resized,
+		it must be big enough to hold all recorded values.
+		\param buffer Buffer.
+		\sa disconnectBuffer().
+	*/
+	void connectBuffer(std::shared_ptr<BufferBase> buffer);
+
+	//! Disconnect buffer from varying.
+	/*!
+		Values will be recorded into internal buffer again.
+		\sa connectBuffer()
+	*/
+	void disconnectBuffer();
+
+	//! Get buffer index.
+	/*!
+		\return Index of buffer varying is recorded to in interleaved mode.
+		\sa ShaderOutput::setVaryingBuffer()
+	*/
+	unsigned int getBufferIndex() const;
+
+	//! Get buffer offset.
+	/*!
+		Availible after output was prepared.
+		\return Offset of varying in single record of interleaved buffer in bytes.
+	*/
+	size_t getBufferOffset() const;
+
+	//! Get buffer stride.
+	/*!
+		Availible after output was prepared.
+		\return Distance between consecutive values of varying in buffer in bytes.
+	*/
+	size_t getBufferStride() const;
+
+	//! Is padding?
+	/*!
+		\return True if varying is gl_SkipComponents padding rather than shader variable.
+	*/
+	bool isPadding() const;
+
 	//! Get GLSL type.
 	/*!
 		\return GLSL type.
@@ -90,7 +147,13 @@ public:
 		Retrieve info about varying from shader program and prepare varying for use.
 		\return True if prepared successfully.
 	*/
-	bool prepare(unsigned int index, unsigned int primitiveCount, size_t* unitSize = 0);
+	bool prepare(unsigned int primitiveCount, size_t* unitSize = 0);
+
+	//! Shrink to fit.
+	/*!
+		Release unused capacity of varying buffer.
+	*/
+	void shrinkToFit();
 
 	//! Handle incoming signal.
 	/*!
@@ -100,13 +163,17 @@ public:
 	*/
 	virtual bool handleSignal(unsigned int signalID, const ObjectBase* callerPtr);
 private:
-    
+	void createBuffer();
+
 	ShaderProgram& m_program;
 	ShaderOutput& m_output;
 	GLSLType m_glslType;
 	std::string m_name;
 	std::shared_ptr<BufferBase> m_buffer;
+	std::shared_ptr<BufferBase> m_connectedBuffer;
 	size_t m_unitSize;
+	unsigned int m_bufferIndex;
+	size_t m_bufferOffset;
 	bool m_prepared;
 };
 
@@ -25,16 +25,46 @@
 
 #include <UniShader/Utility.h>
 #include <UniShader/ShaderOutput.h>
+#include <UniShader/Buffer.h>
+#include <iostream>
 
 UNISHADER_BEGIN
 
 template <typename T>
 typename std::shared_ptr< const Buffer<T> > Varying::getBuffer(){
 	if(m_output.isInterleaved())
-		return m_output.getInterleavedBuffer<T>();
+		return m_output.getInterleavedBuffer<T>(m_bufferIndex);
+	else if(m_connectedBuffer){
+		return std::static_pointer_cast<const Buffer<T>>(m_connectedBuffer);
+	}
 	else{
 		return std::static_pointer_cast<const Buffer<T>>(m_buffer);
 	}
 }
 
+template <typename T>
+StridedView<T> Varying::view(unsigned int access){
+	if(!m_prepared){
+		std::cerr << "ERROR: Varying " << m_name << " isn't prepared" << std::endl;
+		return StridedView<T>();
+	}
+	if(sizeof(T) != m_unitSize){
+		std::cerr << "ERROR: Size of type doesn't match size of varying " << m_name << std::endl;
+		return StridedView<T>();
+	}
+
+	//output buffers are owned by output, so view can write to them
+	std::shared_ptr<Buffer<char>> buffer = std::const_pointer_cast<Buffer<char>>(getBuffer<char>());
+	size_t stride = getBufferStride();
+	if(!buffer || stride == 0 || buffer->getByteSize() < m_bufferOffset + m_unitSize)
+		return StridedView<T>();
+
+	unsigned int count = (buffer->getByteSize() - m_bufferOffset - m_unitSize) / stride + 1;
+	MappedView<char> mapped = buffer->map(BufferRange(), access);
+	if(!mapped.isMapped())
+		return StridedView<T>();
+
+	return StridedView<T>(std::move(mapped), m_bufferOffset, stride, count);
+}
+
 UNISHADER_END
@@ -28,6 +28,7 @@
 #include <UniShader/OpenGL.h>
 #include <UniShader/TypeResolver.h>
 #include <UniShader/Buffer.h>
+#include <UniShader/Varying.h>
 #include <string.h>
 
 using UNISHADER_NAMESPACE;
@@ -35,13 +36,22 @@ using UNISHADER_NAMESPACE;
 Attribute::Attribute(ShaderProgram& program, std::string name):
 m_program(program),
 m_buffer(0),
+m_varyingConnected(false),
+m_appliedBufferID(0),
+m_appliedOffset(0),
 m_name(name),
 m_offset(0),
 m_stride(0),
+m_divisor(0),
+m_appliedDivisor(0),
 m_location(-1),
 m_readingMode(ReadingMode::NONE),
 m_normalize(false),
-m_prepared(false){
+m_prepared(false),
+m_useBinding(false),
+m_enabled(false),
+m_formatDirty(true),
+m_sourceDirty(true){
 	m_program.subscribeReceiver(signalPtr);
 }
 
@@ -55,23 +65,58 @@ Attribute::~Attribute(){
 }
 
 void Attribute::connectBuffer(BufferBase::Ptr buffer, size_t offset, size_t stride){
+	m_varying = Varying::Ptr();
+	m_varyingConnected = false;
 	m_buffer = buffer;
 	m_offset = offset;
 	m_stride = stride;
-    m_prepared = false;
-	sendSignal(SignalID::CHANGED, this);
+	m_sourceDirty = true;
+	if(!m_enabled)
+		m_formatDirty = true;
+	sendSignal(SignalID::SOURCE_CHANGED, this);
+}
+
+void Attribute::connectVarying(Varying::Ptr varying){
+	m_varying = varying;
+	m_varyingConnected = true;
+	m_buffer = 0;
+	m_offset = 0;
+	m_stride = 0;
+	m_sourceDirty = true;
+	if(!m_enabled)
+		m_formatDirty = true;
+	sendSignal(SignalID::SOURCE_CHANGED, this);
 }
 
 void Attribute::disconnectBuffer(){
+	m_varying = Varying::Ptr();
+	m_varyingConnected = false;
 	m_buffer = 0;
 	m_prepared = false;
+	m_formatDirty = true;
 	sendSignal(SignalID::CHANGED, this);
 }
 
 void Attribute::normalize(bool norm){
 	m_normalize = norm;
 	m_prepared = false;
+	m_formatDirty = true;
+	sendSignal(SignalID::CHANGED, this);
+}
+
+bool Attribute::setDivisor(unsigned int divisor){
+	if(divisor != 0 && !glewIsSupported("GL_VERSION_3_3") && !glewIsSupported("GL_ARB_instanced_arrays")){
+		std::cerr << "ERROR: Attribute divisor is not supported by graphics card" << std::endl;
+		return FAILURE;
+	}
+	m_divisor = divisor;
+	m_formatDirty = true;
 	sendSignal(SignalID::CHANGED, this);
+	return SUCCESS;
+}
+
+unsigned int Attribute::getDivisor() const{
+	return m_divisor;
 }
 
 size_t Attribute::getBufferOffset() const{
@@ -97,17 +142,20 @@ std::string Attribute::getName() const{
 
 void Attribute::setBufferOffset(size_t offset){
 	m_offset = offset;
-	sendSignal(SignalID::CHANGED, this);
+	m_sourceDirty = true;
+	sendSignal(SignalID::SOURCE_CHANGED, this);
 }
 
 void Attribute::setBufferStride(size_t stride){
 	m_stride = stride;
-	sendSignal(SignalID::CHANGED, this);
+	m_sourceDirty = true;
+	sendSignal(SignalID::SOURCE_CHANGED, this);
 }
 	
 void Attribute::setReadingMode(ReadingMode readingMode){
 	m_readingMode = readingMode;
 	m_prepared = false;
+	m_formatDirty = true;
 	sendSignal(SignalID::CHANGED, this);
 }
 
@@ -150,6 +198,7 @@ bool Attribute::prepare(){
 		if(!TypeResolver::resolve(type, m_type))
 			return FAILURE;
 
+		m_useBinding = glewIsSupported("GL_ARB_vertex_attrib_binding") != 0;
 		m_prepared = true;
 	}
 
@@ -159,94 +208,240 @@ bool Attribute::prepare(){
 void Attribute::apply(){
 	clearGLErrors();
 
-	if(!m_buffer){
-		std::cerr << "ERROR: Attribute " << m_name <<  " doesn't have buffer conected" << std::endl;
+	if(!prepare())
+		return;
+
+	unsigned int bufferID;
+	size_t offset, stride;
+	if(!resolveSource(bufferID, offset, stride))
+		return;
+
+	if(m_useBinding){
+		//format is stored separately and only needs to be set when it changes
+		if(m_formatDirty && !applyFormat())
+			return;
+
+		//changing source costs single call
+		glBindVertexBuffer(m_location, bufferID, (GLintptr)offset, (GLsizei)stride);
+		printGLError();
+		sourceApplied(bufferID, offset);
 		return;
 	}
 
-	if(!prepare())
+	GLenum bufferDataType;
+	size_t elemSize;
+	if(!resolveFormat(bufferDataType, elemSize))
 		return;
 
+	for(int i = 0; i < m_type.getColumnCount(); i++){
+		glEnableVertexAttribArray(m_location+i);
+		glBindBuffer(GL_ARRAY_BUFFER, bufferID);
+		size_t columnOffset = i*m_type.getColumnSize() * elemSize + offset;
+
+		switch(m_type.getDataType()){
+		case GLSLType::DataType::FLOAT:
+			glVertexAttribPointer(m_location+i, m_type.getColumnSize(), bufferDataType, m_normalize, stride, (void*)columnOffset);
+			break;
+		case GLSLType::DataType::DOUBLE:
+			glVertexAttribLPointer(m_location+i, m_type.getColumnSize(), bufferDataType, stride, (void*)columnOffset);
+			break;
+		case GLSLType::DataType::INT:
+		case GLSLType::DataType::UNSIGNED_INT:
+			glVertexAttribIPointer(m_location+i, m_type.getColumnSize(), bufferDataType, stride, (void*)columnOffset);
+			break;
+		default:
+			std::cerr << "ERROR: Invalid data type" << std::endl;
+			return;
+		}
+		//divisor requires GL 3.3 or ARB_instanced_arrays, so it's only set when used or reset
+		if(m_divisor != 0 || m_appliedDivisor != 0){
+			if(glewIsSupported("GL_VERSION_3_3"))
+				glVertexAttribDivisor(m_location+i, m_divisor);
+			else
+				glVertexAttribDivisorARB(m_location+i, m_divisor);
+		}
+			
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		printGLError();
+	}
+
+	m_appliedDivisor = m_divisor;
+	m_enabled = true;
+	m_formatDirty = false;
+	sourceApplied(bufferID, offset);
+}
+
+bool Attribute::needsApply(){
+	return m_formatDirty || m_sourceDirty || isSourceOutdated();
+}
+
+void Attribute::invalidate(){
+	m_formatDirty = true;
+	m_sourceDirty = true;
+	m_enabled = false;
+}
+
+bool Attribute::isSourceOutdated(){
+	if(!m_varyingConnected || !m_varying)
+		return false;
+
+	std::shared_ptr<const Buffer<char>> buffer = m_varying->getBuffer<char>();
+	if(!buffer)
+		return false;
+
+	return buffer->getGlID() != m_appliedBufferID || m_varying->getBufferOffset() + buffer->getStorageOffset() != m_appliedOffset;
+}
+
+bool Attribute::resolveVarying(){
+	if(!m_varying){
+		std::cerr << "ERROR: Varying connected to attribute " << m_name << " doesn't exist anymore" << std::endl;
+		return FAILURE;
+	}
+
+	std::shared_ptr<const Buffer<char>> buffer = m_varying->getBuffer<char>();
+	if(!buffer){
+		std::cerr << "ERROR: Varying connected to attribute " << m_name << " doesn't have buffer" << std::endl;
+		return FAILURE;
+	}
+
+	//output buffers are owned by output, attribute only reads from them
+	m_buffer = std::const_pointer_cast<BufferBase>(std::static_pointer_cast<const BufferBase>(buffer));
+	m_offset = m_varying->getBufferOffset();
+	return SUCCESS;
+}
+
+bool Attribute::resolveFormat(unsigned int& dataType, size_t& elemSize){
 	//check for conflicts
 	if(m_type.getDataType() == GLSLType::DataType::INT || m_type.getDataType() == GLSLType::DataType::UNSIGNED_INT){
 		if(m_readingMode == ReadingMode::FLOAT || m_readingMode == ReadingMode::DOUBLE){
 			std::cerr << "ERROR: Incompatible data type and data reading mode" << std::endl;
-			return;
+			return FAILURE;
 		}
 	}
 	else if(m_type.getDataType() == GLSLType::DataType::DOUBLE){
 		if(m_readingMode != ReadingMode::DOUBLE){
 			std::cerr << "ERROR: Incompatible data type and data reading mode" << std::endl;
-			return;
+			return FAILURE;
 		}
 	}
 
-	GLenum bufferDataType;
-	size_t elemSize;
 	switch(m_readingMode){
 	case ReadingMode::CHAR:
-		bufferDataType = GL_BYTE;
+		dataType = GL_BYTE;
 		elemSize = 1;
 		break;
 	case ReadingMode::UNSIGNED_CHAR:
-		bufferDataType = GL_UNSIGNED_BYTE;
+		dataType = GL_UNSIGNED_BYTE;
 		elemSize = 1;
 		break;
 	case ReadingMode::SHORT:
-		bufferDataType = GL_SHORT;
+		dataType = GL_SHORT;
 		elemSize = sizeof(short);
 		break;
 	case ReadingMode::UNSIGNED_SHORT:
-		bufferDataType = GL_UNSIGNED_SHORT;
+		dataType = GL_UNSIGNED_SHORT;
 		elemSize = sizeof(unsigned short);
 		break;
 	case ReadingMode::INT:
-		bufferDataType = GL_INT;
+		dataType = GL_INT;
 		elemSize = sizeof(int);
 		break;
 	case ReadingMode::UNSIGNED_INT:
-		bufferDataType = GL_UNSIGNED_INT;
+		dataType = GL_UNSIGNED_INT;
 		elemSize = sizeof(unsigned int);
 		break;
 	case ReadingMode::FLOAT:
-		bufferDataType = GL_FLOAT;
+		dataType = GL_FLOAT;
 		elemSize = sizeof(float);
 		break;
 	case ReadingMode::DOUBLE:
-		bufferDataType = GL_DOUBLE;
+		dataType = GL_DOUBLE;
 		elemSize = sizeof(double);
 		break;
 	default:
 		std::cerr << "ERROR: Invalid data reading mode" << std::endl;
-		return;
+		return FAILURE;
 	}
+	return SUCCESS;
+}
 
-	size_t stride = m_type.getColumnSize() * m_type.getColumnCount() * elemSize + m_stride;
+bool Attribute::resolveSource(unsigned int& bufferID, size_t& offset, size_t& stride){
+	if(m_varyingConnected && !resolveVarying())
+		return FAILURE;
+
+	if(!m_buffer){
+		//stop reading from buffer that was disconnected
+		if(m_enabled){
+			for(int i = 0; i < m_type.getColumnCount(); i++)
+				glDisableVertexAttribArray(m_location+i);
+			printGLError();
+			m_enabled = false;
+		}
+		m_formatDirty = false;
+		m_sourceDirty = false;
+		std::cerr << "ERROR: Attribute " << m_name <<  " doesn't have buffer conected" << std::endl;
+		return FAILURE;
+	}
+
+	GLenum dataType;
+	size_t elemSize;
+	if(!resolveFormat(dataType, elemSize))
+		return FAILURE;
+
+	bufferID = m_buffer->getGlID();
+	offset = m_offset + m_buffer->getStorageOffset();
+	stride = m_type.getColumnSize() * m_type.getColumnCount() * elemSize + m_stride;
+	if(m_varyingConnected && m_varying->getBufferStride() != 0)
+		stride = m_varying->getBufferStride();
+	return SUCCESS;
+}
+
+bool Attribute::hasSource() const{
+	return m_varyingConnected || m_buffer;
+}
+
+bool Attribute::applyFormat(){
+	GLenum bufferDataType;
+	size_t elemSize;
+	if(!resolveFormat(bufferDataType, elemSize))
+		return FAILURE;
 
 	for(int i = 0; i < m_type.getColumnCount(); i++){
 		glEnableVertexAttribArray(m_location+i);
-		glBindBuffer(GL_ARRAY_BUFFER, m_buffer->getGlID());
-		size_t offset = i*m_type.getColumnSize() * elemSize + m_offset;
+		GLuint relOffset = (GLuint)(i*m_type.getColumnSize() * elemSize);
 
 		switch(m_type.getDataType()){
 		case GLSLType::DataType::FLOAT:
-			glVertexAttribPointer(m_location+i, m_type.getColumnSize(), bufferDataType, m_normalize, stride, (void*)offset);
+			glVertexAttribFormat(m_location+i, m_type.getColumnSize(), bufferDataType, m_normalize, relOffset);
 			break;
 		case GLSLType::DataType::DOUBLE:
-			glVertexAttribLPointer(m_location+i, m_type.getColumnSize(), bufferDataType, stride, (void*)offset);
+			glVertexAttribLFormat(m_location+i, m_type.getColumnSize(), bufferDataType, relOffset);
 			break;
 		case GLSLType::DataType::INT:
 		case GLSLType::DataType::UNSIGNED_INT:
-			glVertexAttribIPointer(m_location+i, m_type.getColumnSize(), bufferDataType, stride, (void*)offset);
+			glVertexAttribIFormat(m_location+i, m_type.getColumnSize(), bufferDataType, relOffset);
 			break;
 		default:
 			std::cerr << "ERROR: Invalid data type" << std::endl;
-			return;
+			return FAILURE;
 		}
-			
-		glBindBuffer(GL_ARRAY_BUFFER, 0);
-		printGLError();
+
+		//all columns read from binding point with index of first location
+		glVertexAttribBinding(m_location+i, m_location);
 	}
+	glVertexBindingDivisor(m_location, m_divisor);
+	m_appliedDivisor = m_divisor;
+	printGLError();
+
+	m_enabled = true;
+	m_formatDirty = false;
+	return SUCCESS;
+}
+
+void Attribute::sourceApplied(unsigned int bufferID, size_t offset){
+	m_appliedBufferID = bufferID;
+	m_appliedOffset = offset;
+	m_sourceDirty = false;
 }
 
 bool Attribute::handleSignal(unsigned int signalID, const ObjectBase* callerPtr){
@@ -254,6 +449,7 @@ bool Attribute::handleSignal(unsigned int signalID, const ObjectBase* callerPtr)
 		switch(signalID){
 		case ShaderProgram::SignalID::RELINKED:
 			m_prepared = false;
+			invalidate();
 			return SUCCESS;
 		}
     }
@@ -28,14 +28,24 @@
 
 #include <iostream>
 #include <cstring>
+#include <algorithm>
+#include <limits>
 
 using UNISHADER_NAMESPACE;
 
+unsigned int BufferBase::m_generationCounter = 0;
+
 BufferBase::BufferBase():
 m_byteSize(0),
+m_immutable(false),
+m_storageFlags(StorageFlags::NONE),
 m_frequencyMode(FrequencyMode::STATIC),
 m_natureMode(NatureMode::DRAW),
-m_bufferID(0){
+m_usageHintSet(false),
+m_bufferID(0),
+m_storageOffset(0),
+m_ownsStorage(true),
+m_storageGeneration(++m_generationCounter){
 	clearGLErrors();
 
 	glGenBuffers(1, &m_bufferID);
@@ -50,11 +60,21 @@ const std::string& BufferBase::getClassName() const{
 BufferBase::~BufferBase(){
 	clearGLErrors();
 
-	glDeleteBuffers(1,&m_bufferID);
+	if(m_ownsStorage)
+		glDeleteBuffers(1,&m_bufferID);
 	printGLError();
 }
 
 bool BufferBase::clear(){;
+	if(m_immutable){
+		std::cerr << "ERROR: Buffer with immutable storage can't be cleared" << std::endl;
+		return FAILURE;
+	}
+	if(!m_ownsStorage){
+		std::cerr << "ERROR: Buffer with shared storage can't be cleared" << std::endl;
+		return FAILURE;
+	}
+
 	clearGLErrors();
 
 	glBindBuffer(GL_ARRAY_BUFFER, m_bufferID);
@@ -68,6 +88,53 @@ unsigned int BufferBase::getGlID() const{
 	return m_bufferID;
 }
 
+size_t BufferBase::getStorageOffset() const{
+	return m_storageOffset;
+}
+
+size_t BufferBase::getByteSize() const{
+	return m_byteSize;
+}
+
+bool BufferBase::ownsStorage() const{
+	return m_ownsStorage;
+}
+
+unsigned int BufferBase::getStorageGeneration() const{
+	return m_storageGeneration;
+}
+
+bool BufferBase::isImmutable() const{
+	return m_immutable;
+}
+
+unsigned int BufferBase::getStorageFlags() const{
+	return m_storageFlags;
+}
+
+bool BufferBase::copyFrom(const BufferBase& source, size_t sourceOffset, size_t offset, size_t size){
+	if(sourceOffset + size > source.m_byteSize){
+		std::cerr << "ERROR: Copied range exceeds size of source buffer" << std::endl;
+		return FAILURE;
+	}
+	if(offset + size > m_byteSize){
+		std::cerr << "ERROR: Copied range exceeds size of buffer" << std::endl;
+		return FAILURE;
+	}
+	if(size == 0)
+		return SUCCESS;
+
+	clearGLErrors();
+
+	glBindBuffer(GL_COPY_READ_BUFFER, source.m_bufferID);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, m_bufferID);
+	glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, source.m_storageOffset + sourceOffset, m_storageOffset + offset, size);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+	return !printGLError();
+}
+
 BufferBase::FrequencyMode BufferBase::getFrequencyMode() const{
 	return m_frequencyMode;
 }
@@ -78,10 +145,33 @@ BufferBase::NatureMode BufferBase::getNatureMode() const{
 
 void BufferBase::setFrequencyMode(FrequencyMode frequencyMode){
 	m_frequencyMode = frequencyMode;
+	m_usageHintSet = true;
 }
 	
 void BufferBase::setNatureMode(NatureMode natureMode){
 	m_natureMode = natureMode;
+	m_usageHintSet = true;
+}
+
+bool BufferBase::resolveRange(BufferRange& range, size_t elementSize) const{
+	size_t elementCount = m_byteSize/elementSize;
+
+	if(range.offset >= elementCount){
+		std::cerr << "ERROR: Range exceeds size of buffer" << std::endl;
+		return FAILURE;
+	}
+	if(range.count == 0){
+		if(elementCount - range.offset > std::numeric_limits<unsigned int>::max()){
+			std::cerr << "ERROR: Range is too big to be described by element count" << std::endl;
+			return FAILURE;
+		}
+		range.count = (unsigned int)(elementCount - range.offset);
+	}
+	else if(range.offset + range.count > elementCount){
+		std::cerr << "ERROR: Range exceeds size of buffer" << std::endl;
+		return FAILURE;
+	}
+	return SUCCESS;
 }
 
 bool BufferBase::mapBuffer(void** mappedPtr) const{
@@ -89,7 +179,7 @@ bool BufferBase::mapBuffer(void** mappedPtr) const{
 
 	//map buffer from GPU memory to RAM
 	glBindBuffer(GL_ARRAY_BUFFER, m_bufferID);
-	*mappedPtr = glMapBuffer(GL_ARRAY_BUFFER, GL_READ_ONLY);
+	*mappedPtr = glMapBufferRange(GL_ARRAY_BUFFER, m_storageOffset, m_byteSize, GL_MAP_READ_BIT);
 	if(printGLError()){
 		glUnmapBuffer(GL_ARRAY_BUFFER);
 		glBindBuffer(GL_ARRAY_BUFFER, 0);
@@ -104,7 +194,81 @@ bool BufferBase::unmapBuffer() const{
 	return !printGLError();
 }
 
+bool BufferBase::getPlainSubData(void* data, size_t offset, size_t size) const{
+	clearGLErrors();
+
+	glBindBuffer(GL_ARRAY_BUFFER, m_bufferID);
+	glGetBufferSubData(GL_ARRAY_BUFFER, m_storageOffset + offset, size, data);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	return !printGLError();
+}
+
+bool BufferBase::mapRange(void** mappedPtr, size_t offset, size_t size, unsigned int access) const{
+	GLbitfield flags = 0;
+	if(access & MapAccess::READ)
+		flags |= GL_MAP_READ_BIT;
+	if(access & MapAccess::WRITE)
+		flags |= GL_MAP_WRITE_BIT;
+	if(access & MapAccess::INVALIDATE_RANGE)
+		flags |= GL_MAP_INVALIDATE_RANGE_BIT;
+	if(access & MapAccess::UNSYNCHRONIZED)
+		flags |= GL_MAP_UNSYNCHRONIZED_BIT;
+	if(access & MapAccess::PERSISTENT)
+		flags |= GL_MAP_PERSISTENT_BIT;
+	if(access & MapAccess::COHERENT)
+		flags |= GL_MAP_COHERENT_BIT;
+
+	if(!(flags & (GL_MAP_READ_BIT | GL_MAP_WRITE_BIT))){
+		std::cerr << "ERROR: Buffer must be mapped for reading or writing" << std::endl;
+		return FAILURE;
+	}
+	if((flags & GL_MAP_READ_BIT) && (flags & (GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT))){
+		std::cerr << "ERROR: Invalidating or unsynchronized access can't be used for reading" << std::endl;
+		return FAILURE;
+	}
+	if((access & MapAccess::PERSISTENT) && !(m_storageFlags & StorageFlags::PERSISTENT)){
+		std::cerr << "ERROR: Persistent mapping requires storage allocated with persistent flag" << std::endl;
+		return FAILURE;
+	}
+	if((access & MapAccess::COHERENT) && (!(access & MapAccess::PERSISTENT) || !(m_storageFlags & StorageFlags::COHERENT))){
+		std::cerr << "ERROR: Coherent mapping must be persistent and requires storage allocated with coherent flag" << std::endl;
+		return FAILURE;
+	}
+
+	clearGLErrors();
+
+	glBindBuffer(GL_ARRAY_BUFFER, m_bufferID);
+	*mappedPtr = glMapBufferRange(GL_ARRAY_BUFFER, m_storageOffset + offset, size, flags);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	if(printGLError() || *mappedPtr == 0){
+		*mappedPtr = 0;
+		return FAILURE;
+	}
+	return SUCCESS;
+}
+
+bool BufferBase::unmapRange() const{
+	clearGLErrors();
+
+	glBindBuffer(GL_ARRAY_BUFFER, m_bufferID);
+	glUnmapBuffer(GL_ARRAY_BUFFER);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	return !printGLError();
+}
+
 bool BufferBase::setPlainData(const void* data, size_t size){
+	if(m_immutable){
+		std::cerr << "ERROR: Buffer with immutable storage can't be reallocated" << std::endl;
+		return FAILURE;
+	}
+	if(!m_ownsStorage){
+		std::cerr << "ERROR: Buffer with shared storage can't be reallocated" << std::endl;
+		return FAILURE;
+	}
+
 	clearGLErrors();
 
 	GLenum accessMode = 0;
@@ -165,6 +329,7 @@ bool BufferBase::setPlainData(const void* data, size_t size){
 	glBindBuffer(GL_ARRAY_BUFFER, m_bufferID);
 	glBufferData(GL_ARRAY_BUFFER, size, data, accessMode);
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	m_storageGeneration = ++m_generationCounter;
 
 	sendSignal(SignalID::CHANGED, this);
 
@@ -177,3 +342,143 @@ bool BufferBase::setPlainData(const void* data, size_t size){
 		return SUCCESS;
 	}
 }
+
+bool BufferBase::setPlainSubData(const void* data, size_t offset, size_t size){
+	if(m_immutable && !(m_storageFlags & StorageFlags::DYNAMIC)){
+		std::cerr << "ERROR: Immutable storage wasn't created with dynamic flag" << std::endl;
+		return FAILURE;
+	}
+	if(offset + size > m_byteSize){
+		std::cerr << "ERROR: Data exceed size of buffer" << std::endl;
+		return FAILURE;
+	}
+
+	clearGLErrors();
+
+	glBindBuffer(GL_ARRAY_BUFFER, m_bufferID);
+	glBufferSubData(GL_ARRAY_BUFFER, m_storageOffset + offset, size, data);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	return !printGLError();
+}
+
+static bool compareRanges(const BufferRange& a, const BufferRange& b){
+	return a.offset < b.offset;
+}
+
+bool BufferBase::setPlainRanges(const void* data, std::vector<BufferRange> ranges, size_t elementSize){
+	if(ranges.size() == 0)
+		return SUCCESS;
+
+	if(m_immutable && !(m_storageFlags & StorageFlags::DYNAMIC)){
+		std::cerr << "ERROR: Immutable storage wasn't created with dynamic flag" << std::endl;
+		return FAILURE;
+	}
+
+	for(std::vector<BufferRange>::iterator it = ranges.begin(); it != ranges.end(); it++){
+		if(!resolveRange(*it, elementSize))
+			return FAILURE;
+	}
+
+	std::sort(ranges.begin(), ranges.end(), compareRanges);
+
+	//merge adjacent and overlapping ranges
+	std::vector<BufferRange>::iterator last = ranges.begin();
+	for(std::vector<BufferRange>::iterator it = ranges.begin()+1; it != ranges.end(); it++){
+		unsigned int lastEnd = last->offset + last->count;
+		if(it->offset <= lastEnd){
+			if(it->offset + it->count > lastEnd)
+				last->count = it->offset + it->count - last->offset;
+		}
+		else
+			*(++last) = *it;
+	}
+	ranges.erase(last+1, ranges.end());
+
+	clearGLErrors();
+
+	glBindBuffer(GL_ARRAY_BUFFER, m_bufferID);
+	for(std::vector<BufferRange>::iterator it = ranges.begin(); it != ranges.end(); it++){
+		size_t offset = it->offset * elementSize;
+		glBufferSubData(GL_ARRAY_BUFFER, m_storageOffset + offset, it->count * elementSize, (const char*)data + offset);
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	return !printGLError();
+}
+
+bool BufferBase::setPlainStorage(const void* data, size_t size, unsigned int flags){
+	if(m_immutable){
+		std::cerr << "ERROR: Buffer already has immutable storage" << std::endl;
+		return FAILURE;
+	}
+	if(!m_ownsStorage){
+		std::cerr << "ERROR: Buffer with shared storage can't be reallocated" << std::endl;
+		return FAILURE;
+	}
+
+	if(!glewIsSupported("GL_ARB_buffer_storage")){
+		//fall back to mutable storage, derive usage hint from flags unless user chose one
+		if(!m_usageHintSet){
+			m_frequencyMode = (flags & StorageFlags::DYNAMIC) ? FrequencyMode::DYNAMIC : ((flags & StorageFlags::MAP_WRITE) ? FrequencyMode::STREAM : FrequencyMode::STATIC);
+			m_natureMode = (flags & StorageFlags::MAP_READ) ? NatureMode::READ : NatureMode::DRAW;
+		}
+		if(!setPlainData(data, size))
+			return FAILURE;
+
+		m_immutable = true;
+		m_storageFlags = flags & ~(StorageFlags::PERSISTENT | StorageFlags::COHERENT);
+		return SUCCESS;
+	}
+
+	GLbitfield glFlags = 0;
+	if(flags & StorageFlags::DYNAMIC)
+		glFlags |= GL_DYNAMIC_STORAGE_BIT;
+	if(flags & StorageFlags::MAP_READ)
+		glFlags |= GL_MAP_READ_BIT;
+	if(flags & StorageFlags::MAP_WRITE)
+		glFlags |= GL_MAP_WRITE_BIT;
+	if(flags & StorageFlags::PERSISTENT)
+		glFlags |= GL_MAP_PERSISTENT_BIT;
+	if(flags & StorageFlags::COHERENT)
+		glFlags |= GL_MAP_COHERENT_BIT;
+	if(flags & StorageFlags::CLIENT_STORAGE)
+		glFlags |= GL_CLIENT_STORAGE_BIT;
+
+	clearGLErrors();
+
+	glBindBuffer(GL_ARRAY_BUFFER, m_bufferID);
+	glBufferStorage(GL_ARRAY_BUFFER, size, data, glFlags);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	m_storageGeneration = ++m_generationCounter;
+
+	sendSignal(SignalID::CHANGED, this);
+
+	if(printGLError()){
+		m_byteSize = 0;
+		return FAILURE;
+	}
+	else{
+		m_byteSize = size;
+		m_immutable = true;
+		m_storageFlags = flags;
+		return SUCCESS;
+	}
+}
+
+void BufferBase::attachStorage(unsigned int bufferID, size_t offset, size_t size){
+	if(m_ownsStorage){
+		clearGLErrors();
+
+		glDeleteBuffers(1, &m_bufferID);
+		printGLError();
+		m_ownsStorage = false;
+	}
+
+	m_bufferID = bufferID;
+	m_storageOffset = offset;
+	m_byteSize = size;
+	m_storageGeneration = ++m_generationCounter;
+
+	sendSignal(SignalID::CHANGED, this);
+}
\ No newline at end of file
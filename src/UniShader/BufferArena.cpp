@@ -0,0 +1,209 @@
+/*
+* UniShader - Interface for GPGPU and working with shader programs
+* Copyright (c) 2011-2013 Ivan Sevcik - ivan-sevcik@hotmail.com
+*
+* This software is provided 'as-is', without any express or
+* implied warranty. In no event will the authors be held
+* liable for any damages arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute
+* it freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented;
+*    you must not claim that you wrote the original software.
+*    If you use this software in a product, an acknowledgment
+*    in the product documentation would be appreciated but
+*    is not required.
+*
+* 2. Altered source versions must be plainly marked as such,
+*    and must not be misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any
+*    source distribution.
+*/
+
+#include <UniShader/BufferArena.h>
+#include <UniShader/OpenGL.h>
+
+#include <iostream>
+
+using UNISHADER_NAMESPACE;
+
+BufferArena::Statistics::Statistics():
+blockCount(0),
+allocationCount(0),
+totalAllocations(0),
+totalReleases(0),
+reservedBytes(0),
+allocatedBytes(0),
+largestFreeRange(0){
+
+}
+
+BufferArena::BufferArena(size_t blockSize, size_t alignment):
+m_blockSize(blockSize),
+m_alignment(alignment),
+m_totalAllocations(0),
+m_totalReleases(0){
+
+}
+
+const std::string& BufferArena::getClassName() const{
+	static const std::string name("us::BufferArena");
+	return name;
+}
+
+BufferArena::~BufferArena(){
+	clearGLErrors();
+
+	for(std::deque<Block>::iterator it = m_blocks.begin(); it != m_blocks.end(); it++)
+		glDeleteBuffers(1, &it->bufferID);
+
+	printGLError();
+}
+
+BufferArena::Ptr BufferArena::create(size_t blockSize, size_t alignment){
+	if(blockSize == 0){
+		std::cerr << "ERROR: Block size must be nonzero" << std::endl;
+		return 0;
+	}
+	if(alignment == 0 || (alignment & (alignment - 1)) != 0){
+		std::cerr << "ERROR: Alignment must be power of two" << std::endl;
+		return 0;
+	}
+
+	Ptr ptr(new BufferArena(blockSize, alignment));
+	return ptr;
+}
+
+bool BufferArena::allocate(size_t size, unsigned int& bufferID, size_t& offset){
+	if(size == 0){
+		std::cerr << "ERROR: Can't allocate zero sized range" << std::endl;
+		return FAILURE;
+	}
+
+	size_t alignedSize = (size + m_alignment - 1) & ~(m_alignment - 1);
+
+	for(unsigned int pass = 0; pass < 2; pass++){
+		for(std::deque<Block>::iterator it = m_blocks.begin(); it != m_blocks.end(); it++){
+			for(std::map<size_t, size_t>::iterator range = it->freeRanges.begin(); range != it->freeRanges.end(); range++){
+				if(range->second < alignedSize)
+					continue;
+
+				bufferID = it->bufferID;
+				offset = range->first;
+
+				//keep rest of free range
+				if(range->second > alignedSize)
+					it->freeRanges[offset + alignedSize] = range->second - alignedSize;
+				it->freeRanges.erase(range);
+				it->usedRanges[offset] = alignedSize;
+
+				m_totalAllocations++;
+				return SUCCESS;
+			}
+		}
+
+		//no free range is big enough, add new block and try again
+		if(pass == 0 && !addBlock(alignedSize > m_blockSize ? alignedSize : m_blockSize))
+			return FAILURE;
+	}
+
+	return FAILURE;
+}
+
+void BufferArena::release(unsigned int bufferID, size_t offset){
+	for(std::deque<Block>::iterator it = m_blocks.begin(); it != m_blocks.end(); it++){
+		if(it->bufferID != bufferID)
+			continue;
+
+		std::map<size_t, size_t>::iterator used = it->usedRanges.find(offset);
+		if(used == it->usedRanges.end())
+			return;
+
+		size_t size = used->second;
+		it->usedRanges.erase(used);
+		m_totalReleases++;
+
+		//merge with following free range
+		std::map<size_t, size_t>::iterator next = it->freeRanges.find(offset + size);
+		if(next != it->freeRanges.end()){
+			size += next->second;
+			it->freeRanges.erase(next);
+		}
+
+		//merge with preceding free range
+		std::map<size_t, size_t>::iterator range = it->freeRanges.insert(std::make_pair(offset, size)).first;
+		if(range != it->freeRanges.begin()){
+			std::map<size_t, size_t>::iterator prev = range;
+			prev--;
+			if(prev->first + prev->second == offset){
+				prev->second += size;
+				it->freeRanges.erase(range);
+			}
+		}
+
+		//release empty oversized blocks, regular blocks are kept for reuse
+		if(it->usedRanges.empty() && it->size > m_blockSize){
+			clearGLErrors();
+
+			glDeleteBuffers(1, &it->bufferID);
+			printGLError();
+			m_blocks.erase(it);
+		}
+		return;
+	}
+}
+
+size_t BufferArena::getBlockSize() const{
+	return m_blockSize;
+}
+
+size_t BufferArena::getAlignment() const{
+	return m_alignment;
+}
+
+BufferArena::Statistics BufferArena::getStatistics() const{
+	Statistics stats;
+
+	stats.blockCount = (unsigned int)m_blocks.size();
+	stats.totalAllocations = m_totalAllocations;
+	stats.totalReleases = m_totalReleases;
+
+	for(std::deque<Block>::const_iterator it = m_blocks.begin(); it != m_blocks.end(); it++){
+		stats.reservedBytes += it->size;
+		stats.allocationCount += (unsigned int)it->usedRanges.size();
+		for(std::map<size_t, size_t>::const_iterator range = it->usedRanges.begin(); range != it->usedRanges.end(); range++)
+			stats.allocatedBytes += range->second;
+		for(std::map<size_t, size_t>::const_iterator range = it->freeRanges.begin(); range != it->freeRanges.end(); range++){
+			if(range->second > stats.largestFreeRange)
+				stats.largestFreeRange = range->second;
+		}
+	}
+
+	return stats;
+}
+
+bool BufferArena::addBlock(size_t size){
+	clearGLErrors();
+
+	Block block;
+	block.bufferID = 0;
+	block.size = size;
+
+	glGenBuffers(1, &block.bufferID);
+	glBindBuffer(GL_ARRAY_BUFFER, block.bufferID);
+	glBufferData(GL_ARRAY_BUFFER, size, 0, GL_DYNAMIC_COPY);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	if(printGLError()){
+		std::cerr << "ERROR: Failed to allocate block of buffer arena" << std::endl;
+		glDeleteBuffers(1, &block.bufferID);
+		return FAILURE;
+	}
+
+	block.freeRanges[0] = size;
+	m_blocks.push_back(block);
+	return SUCCESS;
+}
@@ -0,0 +1,83 @@
+/*
+* UniShader - Interface for GPGPU and working with shader programs
+* Copyright (c) 2011-2013 Ivan Sevcik - ivan-sevcik@hotmail.com
+*
+* This software is provided 'as-is', without any express or
+* implied warranty. In no event will the authors be held
+* liable for any damages arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute
+* it freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented;
+*    you must not claim that you wrote the original software.
+*    If you use this software in a product, an acknowledgment
+*    in the product documentation would be appreciated but
+*    is not required.
+*
+* 2. Altered source versions must be plainly marked as such,
+*    and must not be misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any
+*    source distribution.
+*/
+
+#include <UniShader/Fence.h>
+#include <UniShader/OpenGL.h>
+
+using UNISHADER_NAMESPACE;
+
+Fence::Fence():
+m_sync(0){
+
+}
+
+Fence::~Fence(){
+	clear();
+}
+
+void Fence::insert(){
+	clear();
+	m_sync = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	//polling doesn't flush, fence must reach graphics card to ever be signaled
+	glFlush();
+}
+
+bool Fence::isSet() const{
+	return m_sync != 0;
+}
+
+bool Fence::isSignaled(){
+	if(!m_sync)
+		return true;
+
+	GLint status = GL_UNSIGNALED;
+	glGetSynciv((GLsync)m_sync, GL_SYNC_STATUS, sizeof(status), 0, &status);
+	if(status == GL_SIGNALED){
+		clear();
+		return true;
+	}
+	return false;
+}
+
+bool Fence::wait(unsigned long long timeout){
+	if(!m_sync)
+		return true;
+
+	GLenum result = glClientWaitSync((GLsync)m_sync, GL_SYNC_FLUSH_COMMANDS_BIT, timeout);
+	if(result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED){
+		clear();
+		return true;
+	}
+	if(result == GL_WAIT_FAILED)
+		std::cerr << "ERROR: Waiting for fence failed" << std::endl;
+	return false;
+}
+
+void Fence::clear(){
+	if(m_sync){
+		glDeleteSync((GLsync)m_sync);
+		m_sync = 0;
+	}
+}
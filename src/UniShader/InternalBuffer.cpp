@@ -24,10 +24,14 @@
 */
 
 #include <UniShader/InternalBuffer.h>
+#include <UniShader/BufferArena.h>
 
 using UNISHADER_NAMESPACE;
 
-InternalBuffer::InternalBuffer(){
+InternalBuffer::InternalBuffer(BufferArena::Ptr arena):
+m_arena(arena),
+m_capacity(0),
+m_growthFactor(1.5f){
 
 }
 
@@ -37,11 +41,12 @@ const std::string& InternalBuffer::getClassName() const{
 }
 
 InternalBuffer::~InternalBuffer(){
-
+	if(m_arena && m_capacity != 0)
+		m_arena->release(getGlID(), getStorageOffset());
 }
 
-InternalBuffer::Ptr InternalBuffer::create(){
-	Ptr ptr(new InternalBuffer);
+InternalBuffer::Ptr InternalBuffer::create(BufferArena::Ptr arena){
+	Ptr ptr(new InternalBuffer(arena));
 	return ptr;
 }
 
@@ -49,6 +54,73 @@ size_t InternalBuffer::getSize() const{
 	return m_byteSize;
 }
 
-void InternalBuffer::resize(size_t size){
-	setPlainData(0,size);
+size_t InternalBuffer::getCapacity() const{
+	return m_capacity;
+}
+
+float InternalBuffer::getGrowthFactor() const{
+	return m_growthFactor;
+}
+
+void InternalBuffer::setGrowthFactor(float factor){
+	m_growthFactor = factor < 1.0f ? 1.0f : factor;
+}
+
+bool InternalBuffer::resize(size_t size){
+	if(size > m_capacity){
+		size_t grown = (size_t)((double)m_capacity * m_growthFactor);
+		if(!reallocate(grown > size ? grown : size))
+			return FAILURE;
+	}
+	//storage stays the same when size fits capacity, but users still need to know
+	if(size != m_byteSize){
+		m_byteSize = size;
+		sendSignal(SignalID::CHANGED, this);
+	}
+	return SUCCESS;
+}
+
+void InternalBuffer::reserve(size_t capacity){
+	if(capacity > m_capacity){
+		size_t size = m_byteSize;
+		if(reallocate(capacity))
+			m_byteSize = size;
+	}
+}
+
+void InternalBuffer::shrinkToFit(){
+	if(m_byteSize != m_capacity){
+		size_t size = m_byteSize;
+		if(reallocate(size))
+			m_byteSize = size;
+	}
+}
+
+bool InternalBuffer::reallocate(size_t capacity){
+	if(!m_arena){
+		if(!setPlainData(0, capacity)){
+			m_capacity = 0;
+			return FAILURE;
+		}
+		m_capacity = capacity;
+		return SUCCESS;
+	}
+
+	//range of arena can't be empty, so keep current one instead of leaving buffer without storage
+	if(capacity == 0)
+		return SUCCESS;
+
+	//allocate new range first, so that buffer keeps previous storage on failure
+	unsigned int bufferID = 0;
+	size_t offset = 0;
+	if(!m_arena->allocate(capacity, bufferID, offset)){
+		std::cerr << "ERROR: Failed to allocate " << capacity << " bytes from buffer arena" << std::endl;
+		return FAILURE;
+	}
+
+	if(m_capacity != 0)
+		m_arena->release(getGlID(), getStorageOffset());
+	attachStorage(bufferID, offset, capacity);
+	m_capacity = capacity;
+	return SUCCESS;
 }
@@ -0,0 +1,122 @@
+/*
+* UniShader - Interface for GPGPU and working with shader programs
+* Copyright (c) 2011-2013 Ivan Sevcik - ivan-sevcik@hotmail.com
+*
+* This software is provided 'as-is', without any express or
+* implied warranty. In no event will the authors be held
+* liable for any damages arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute
+* it freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented;
+*    you must not claim that you wrote the original software.
+*    If you use this software in a product, an acknowledgment
+*    in the product documentation would be appreciated but
+*    is not required.
+*
+* 2. Altered source versions must be plainly marked as such,
+*    and must not be misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any
+*    source distribution.
+*/
+
+#include <UniShader/Readback.h>
+#include <UniShader/Buffer.h>
+#include <UniShader/OpenGL.h>
+
+#include <iostream>
+#include <cstring>
+
+using UNISHADER_NAMESPACE;
+
+ReadbackBase::ReadbackBase():
+m_stagingID(0),
+m_byteSize(0){
+	clearGLErrors();
+
+	glGenBuffers(1, &m_stagingID);
+	printGLError();
+}
+
+const std::string& ReadbackBase::getClassName() const{
+	static const std::string name("us::ReadbackBase");
+	return name;
+}
+
+ReadbackBase::~ReadbackBase(){
+	clearGLErrors();
+
+	glDeleteBuffers(1, &m_stagingID);
+	printGLError();
+}
+
+bool ReadbackBase::isReady(){
+	return m_fence.isSignaled();
+}
+
+bool ReadbackBase::wait(unsigned long long timeout){
+	return m_fence.wait(timeout);
+}
+
+size_t ReadbackBase::getByteSize() const{
+	return m_byteSize;
+}
+
+bool ReadbackBase::start(const BufferBase& source, size_t offset, size_t size){
+	if(m_stagingID == 0)
+		return FAILURE;
+
+	clearGLErrors();
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, m_stagingID);
+	if(size != m_byteSize)
+		glBufferData(GL_PIXEL_PACK_BUFFER, size, 0, GL_STREAM_READ);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	glBindBuffer(GL_COPY_READ_BUFFER, source.getGlID());
+	glBindBuffer(GL_COPY_WRITE_BUFFER, m_stagingID);
+	glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, source.getStorageOffset() + offset, 0, size);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+	//fence flushes copy command, so polling isReady() makes progress
+	m_fence.insert();
+
+	if(printGLError()){
+		m_fence.clear();
+		m_byteSize = 0;
+		return FAILURE;
+	}
+	m_byteSize = size;
+	return SUCCESS;
+}
+
+bool ReadbackBase::copyPlainData(void* data){
+	if(m_byteSize == 0)
+		return SUCCESS;
+
+	//wait indefinitely, caller asked for data
+	if(!m_fence.wait(GL_TIMEOUT_IGNORED)){
+		std::cerr << "ERROR: Failed to wait for readback" << std::endl;
+		return FAILURE;
+	}
+
+	clearGLErrors();
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, m_stagingID);
+	void* mappedPtr = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, m_byteSize, GL_MAP_READ_BIT);
+	if(printGLError() || !mappedPtr){
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+		std::cerr << "ERROR: Failed to access GPU memory" << std::endl;
+		return FAILURE;
+	}
+
+	memcpy(data, mappedPtr, m_byteSize);
+
+	glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	return !printGLError();
+}
@@ -29,12 +29,15 @@
 #include <UniShader/Attribute.h>
 #include <UniShader/Uniform.h>
 
+#include <vector>
+
 using UNISHADER_NAMESPACE;
 
 ShaderInput::ShaderInput(ShaderProgram& program):
 m_program(program),
 m_VAO(0),
 m_remakeVAO(true),
+m_useMultiBind(false),
 m_active(false){
 	m_program.subscribeReceiver(signalPtr);
 }
@@ -111,18 +114,113 @@ void ShaderInput::prepare(){
 		return;
 	}
 
+	bool bound = false;
 	if(m_remakeVAO){
 		clearGLErrors();
 		glDeleteVertexArrays(1, &m_VAO);
 		glGenVertexArrays(1, &m_VAO);
 		glBindVertexArray(m_VAO);
 		printGLError();
+		bound = true;
+
+		m_useMultiBind = glewIsSupported("GL_ARB_vertex_attrib_binding") != 0 && glewIsSupported("GL_ARB_multi_bind") != 0;
 
-		//apply attributes to VAO
+		//new VAO has no state, all attributes must be applied
 		for(std::deque< std::shared_ptr<Attribute> >::iterator it = m_attribs.begin(); it != m_attribs.end(); it++)
+			(*it)->invalidate();
+		m_remakeVAO = false;
+	}
+
+	if(!m_useMultiBind){
+		//keep VAO and reapply only attributes that changed
+		for(std::deque< std::shared_ptr<Attribute> >::iterator it = m_attribs.begin(); it != m_attribs.end(); it++){
+			if(!(*it)->needsApply())
+				continue;
+
+			if(!bound){
+				clearGLErrors();
+				glBindVertexArray(m_VAO);
+				printGLError();
+				bound = true;
+			}
 			(*it)->apply();
+		}
+	}
+	else{
+		//format is set up once, sources of all attributes are bound with single call
+		bool changed = false;
+		for(std::deque< std::shared_ptr<Attribute> >::iterator it = m_attribs.begin(); it != m_attribs.end(); it++){
+			if(!(*it)->needsApply())
+				continue;
 
-		glBindVertexArray(0);
+			if(!bound){
+				clearGLErrors();
+				glBindVertexArray(m_VAO);
+				printGLError();
+				bound = true;
+			}
+			if((*it)->prepare() && (*it)->m_formatDirty)
+				(*it)->applyFormat();
+			changed = true;
+		}
+
+		if(changed)
+			bindSources();
+	}
+
+	//active input keeps its VAO bound
+	if(bound)
+		glBindVertexArray(m_active ? m_VAO : 0);
+}
+
+void ShaderInput::bindSources(){
+	std::vector< std::shared_ptr<Attribute> > bound;
+	std::vector<GLuint> buffers;
+	std::vector<GLintptr> offsets;
+	std::vector<GLsizei> strides;
+	int first = -1;
+
+	for(std::deque< std::shared_ptr<Attribute> >::iterator it = m_attribs.begin(); it != m_attribs.end(); it++){
+		//attribute left without buffer was already reported when it changed
+		if(!(*it)->hasSource() && !(*it)->needsApply())
+			continue;
+
+		unsigned int bufferID;
+		size_t offset, stride;
+		if(!(*it)->prepare() || !(*it)->resolveSource(bufferID, offset, stride))
+			continue;
+
+		//binding points are indexed by attribute locations
+		int location = (*it)->m_location;
+		if(first == -1)
+			first = location;
+		if(location < first){
+			buffers.insert(buffers.begin(), first-location, 0);
+			offsets.insert(offsets.begin(), first-location, 0);
+			strides.insert(strides.begin(), first-location, 0);
+			first = location;
+		}
+		if(location-first >= (int)buffers.size()){
+			buffers.resize(location-first+1, 0);
+			offsets.resize(location-first+1, 0);
+			strides.resize(location-first+1, 0);
+		}
+		buffers[location-first] = bufferID;
+		offsets[location-first] = (GLintptr)offset;
+		strides[location-first] = (GLsizei)stride;
+		bound.push_back(*it);
+	}
+
+	if(bound.empty())
+		return;
+
+	clearGLErrors();
+	glBindVertexBuffers((GLuint)first, (GLsizei)buffers.size(), &buffers[0], &offsets[0], &strides[0]);
+	printGLError();
+
+	for(std::vector< std::shared_ptr<Attribute> >::iterator it = bound.begin(); it != bound.end(); it++){
+		int index = (*it)->m_location - first;
+		(*it)->sourceApplied(buffers[index], offsets[index]);
 	}
 }
 
@@ -141,6 +239,29 @@ void ShaderInput::activate(){
 	}
 }
 
+unsigned int ShaderInput::refresh(){
+	if(!m_active)
+		return 0;
+
+	for(std::deque< std::shared_ptr<Uniform> >::iterator it = m_uniforms.begin(); it != m_uniforms.end(); it++){
+		if((*it)->needsApply()){
+			//texture sources might change, release them before applying again
+			deactivate();
+			prepare();
+			activate();
+			return 0;
+		}
+	}
+
+	prepare();
+
+	//VAO unbind and bind, and rebinding of texture sources
+	unsigned int skipped = 2;
+	for(std::deque< std::shared_ptr<Uniform> >::iterator it = m_uniforms.begin(); it != m_uniforms.end(); it++)
+		skipped += (*it)->estimateRebindCallCount();
+	return skipped;
+}
+
 bool ShaderInput::isActive(){
 	return m_active;
 }
@@ -159,7 +280,8 @@ bool ShaderInput::handleSignal(unsigned int signalID, const ObjectBase* callerPt
 	if(callerPtr->getClassName() == "us::Attribute"){
 		switch(signalID){
 		case Attribute::SignalID::CHANGED:
-			m_remakeVAO = true;
+		case Attribute::SignalID::SOURCE_CHANGED:
+			//attributes track their own changes and are reapplied in prepare()
 			return SUCCESS;
 		}
 	}
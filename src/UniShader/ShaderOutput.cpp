@@ -27,21 +27,32 @@
 #include <UniShader/UniShader.h>
 #include <UniShader/ShaderProgram.h>
 #include <UniShader/InternalBuffer.h>
+#include <UniShader/BufferArena.h>
 #include <UniShader/OpenGL.h>
 
 #include <cstring>
 
 using UNISHADER_NAMESPACE;
 
+
 ShaderOutput::ShaderOutput(ShaderProgram& program):
 m_program(program),
-m_interleavedBuffer(0),
-m_overallSize(0),
-m_query(0),
-m_primitivesProcessed(0),
+m_arena(0),
+m_growthFactor(1.5f),
+m_reservedCount(0),
+m_maxOutputs(1),
+m_autoGrow(false),
+m_feedbackID(0),
+m_queryCount(0),
+m_streamCount(1),
+m_queryStreamCount(0),
+m_addBufferIndex(0),
+m_maxSeparateComponents(0),
 m_interleaved(false),
+m_separateByBuffers(false),
 m_prepared(false),
-m_active(false){
+m_active(false),
+m_paused(false){
 
 }
 
@@ -51,15 +62,40 @@ const std::string& ShaderOutput::getClassName() const{
 }
 
 ShaderOutput::~ShaderOutput(){
+	clearGLErrors();
+
+	if(m_feedbackID)
+		glDeleteTransformFeedbacks(1, &m_feedbackID);
+	if(!m_freeQueries.empty())
+		glDeleteQueries((GLsizei)m_freeQueries.size(), &m_freeQueries[0]);
+	for(unsigned int i = 0; i < m_queries.size(); i++){
+		if(m_queries[i])
+			glDeleteQueries(1, &m_queries[i]);
+	}
+	for(unsigned int i = 0; i < m_pendingQueries.size(); i++){
+		if(m_pendingQueries[i])
+			glDeleteQueries(1, &m_pendingQueries[i]);
+	}
 
+	printGLError();
 }
 
 Varying::Ptr ShaderOutput::addVarying(std::string name){
-	for(std::deque< std::shared_ptr<Varying> >::iterator it = m_varyings.begin(); it != m_varyings.end(); it++){
-		if((*it)->getName() == name)
-			return Varying::Ptr();
+	if(name == "gl_NextBuffer"){
+		//following varyings are recorded to next buffer
+		m_addBufferIndex++;
+		return Varying::Ptr();
+	}
+
+	//gaps of the same size can be used repeatedly
+	if(name.compare(0, 17, "gl_SkipComponents") != 0){
+		for(std::deque< std::shared_ptr<Varying> >::iterator it = m_varyings.begin(); it != m_varyings.end(); it++){
+			if((*it)->getName() == name)
+				return Varying::Ptr();
+		}
 	}
 	m_varyings.push_back( std::shared_ptr<Varying>(new Varying(m_program, *this, name)) );
+	m_varyings.back()->m_bufferIndex = m_addBufferIndex;
 
 	size_t size = m_varyings.back()->getName().size()+1;
 	m_names.push_back(new char[size]);
@@ -98,14 +134,14 @@ void ShaderOutput::removeVarying(std::string name){
 void ShaderOutput::interleave(bool interl){
 	if(interl != m_interleaved){
 		m_interleaved = interl;
+		//buffers are recreated, don't trust bindings kept in feedback object
+		m_bindings.clear();
 		if(m_interleaved){
-			m_interleavedBuffer = BufferBase::Ptr(std::dynamic_pointer_cast<BufferBase>(InternalBuffer::create()));
-			m_interleavedBuffer->setFrequencyMode(BufferBase::FrequencyMode::DYNAMIC);
-			m_interleavedBuffer->setNatureMode(BufferBase::NatureMode::COPY);
+			resizeInterleavedBuffers(getBufferCount());
 			sendSignal(SignalID::INTERLEAVED, this);
 		}
 		else{
-			m_interleavedBuffer = 0;
+			m_interleavedBuffers.clear();
 			sendSignal(SignalID::DEINTERLEAVED, this);
 		}
 		m_prepared = false;
@@ -117,6 +153,91 @@ bool ShaderOutput::isInterleaved(){
 	return m_interleaved;
 }
 
+bool ShaderOutput::setVaryingBuffer(std::string name, unsigned int buffer){
+	for(std::deque< std::shared_ptr<Varying> >::iterator it = m_varyings.begin(); it != m_varyings.end(); it++){
+		if((*it)->getName() == name){
+			if((*it)->m_bufferIndex != buffer){
+				(*it)->m_bufferIndex = buffer;
+				m_prepared = false;
+				sendSignal(SignalID::CHANGED, this);
+			}
+			return SUCCESS;
+		}
+	}
+	return FAILURE;
+}
+
+unsigned int ShaderOutput::getBufferCount(){
+	if(!m_interleaved)
+		return (unsigned int)m_varyings.size();
+
+	unsigned int count = 1;
+	for(std::deque< std::shared_ptr<Varying> >::iterator it = m_varyings.begin(); it != m_varyings.end(); it++){
+		if((*it)->getBufferIndex() + 1 > count)
+			count = (*it)->getBufferIndex() + 1;
+	}
+	return count;
+}
+
+void ShaderOutput::setStreamCount(unsigned int count){
+	if(count == 0)
+		count = 1;
+	if(count > 1 && !glewIsSupported("GL_ARB_transform_feedback3")){
+		std::cerr << "ERROR: Multiple vertex streams are not supported by graphics card" << std::endl;
+		return;
+	}
+	m_streamCount = count;
+}
+
+unsigned int ShaderOutput::getStreamCount(){
+	return m_streamCount;
+}
+
+void ShaderOutput::setArena(BufferArena::Ptr arena){
+	if(arena == m_arena)
+		return;
+
+	m_arena = arena;
+	m_bindings.clear();
+	if(m_interleaved){
+		m_interleavedBuffers.clear();
+		resizeInterleavedBuffers(getBufferCount());
+	}
+	m_prepared = false;
+	sendSignal(SignalID::ARENA_CHANGED, this);
+}
+
+BufferArena::Ptr ShaderOutput::getArena(){
+	return m_arena;
+}
+
+void ShaderOutput::setGrowthFactor(float factor){
+	m_growthFactor = factor < 1.0f ? 1.0f : factor;
+}
+
+float ShaderOutput::getGrowthFactor(){
+	return m_growthFactor;
+}
+
+void ShaderOutput::reserve(unsigned int primitiveCount){
+	m_reservedCount = primitiveCount;
+}
+
+unsigned int ShaderOutput::getReservedCount(){
+	return m_reservedCount;
+}
+
+void ShaderOutput::shrinkToFit(){
+	m_reservedCount = 0;
+	if(m_interleaved)
+		for(unsigned int i = 0; i < m_interleavedBuffers.size(); i++)
+			std::static_pointer_cast<InternalBuffer>(m_interleavedBuffers[i])->shrinkToFit();
+	else{
+		for(std::deque< std::shared_ptr<Varying> >::iterator it = m_varyings.begin(); it != m_varyings.end(); it++)
+			(*it)->shrinkToFit();
+	}
+}
+
 void ShaderOutput::setUp(){
 	m_prepared = false;
 
@@ -125,10 +246,45 @@ void ShaderOutput::setUp(){
 
 	clearGLErrors();
 
-	if(m_interleaved)
-		glTransformFeedbackVaryings(m_program.getGlID(), m_names.size(), &m_names[0], GL_INTERLEAVED_ATTRIBS);
-	else
-		glTransformFeedbackVaryings(m_program.getGlID(), m_names.size(), &m_names[0], GL_SEPARATE_ATTRIBS);
+	if(m_interleaved){
+		unsigned int bufferCount = getBufferCount();
+		if(bufferCount > 1 && !glewIsSupported("GL_ARB_transform_feedback3")){
+			std::cerr << "ERROR: Recording interleaved output to multiple buffers is not supported by graphics card" << std::endl;
+			return;
+		}
+
+		//group varyings by buffer and separate buffers with gl_NextBuffer
+		std::vector<const char*> names;
+		for(unsigned int buffer = 0; buffer < bufferCount; buffer++){
+			if(buffer != 0)
+				names.push_back("gl_NextBuffer");
+			unsigned int i = 0;
+			for(std::deque< std::shared_ptr<Varying> >::iterator it = m_varyings.begin(); it != m_varyings.end(); it++, i++){
+				if((*it)->getBufferIndex() == buffer)
+					names.push_back(m_names[i]);
+			}
+		}
+		glTransformFeedbackVaryings(m_program.getGlID(), (GLsizei)names.size(), &names[0], GL_INTERLEAVED_ATTRIBS);
+		m_separateByBuffers = false;
+	}
+	else if(glewIsSupported("GL_ARB_transform_feedback3")){
+		//separate attribs mode limits each varying to GL_MAX_TRANSFORM_FEEDBACK_SEPARATE_COMPONENTS
+		//(can be as low as 4, too few for matrices), so record each varying to its own buffer
+		//with interleaved capture, which is limited only by total interleaved components
+		std::vector<const char*> names;
+		for(unsigned int i = 0; i < m_names.size(); i++){
+			if(i != 0)
+				names.push_back("gl_NextBuffer");
+			names.push_back(m_names[i]);
+		}
+		glTransformFeedbackVaryings(m_program.getGlID(), (GLsizei)names.size(), &names[0], GL_INTERLEAVED_ATTRIBS);
+		m_separateByBuffers = true;
+	}
+	else{
+		glGetIntegerv(GL_MAX_TRANSFORM_FEEDBACK_SEPARATE_COMPONENTS, &m_maxSeparateComponents);
+		glTransformFeedbackVaryings(m_program.getGlID(), (GLsizei)m_names.size(), &m_names[0], GL_SEPARATE_ATTRIBS);
+		m_separateByBuffers = false;
+	}
 
 	printGLError();
 }
@@ -146,23 +302,31 @@ bool ShaderOutput::prepare(unsigned int primitiveCount){
 
 		if(!m_prepared){
 			size_t unitSize = 0;
-			m_overallSize = 0;
-			unsigned int i = 0;
-			for(std::deque< std::shared_ptr<Varying> >::iterator it = m_varyings.begin(); it != m_varyings.end(); it++, i++){
-				(*it)->prepare(i, primitiveCount, &unitSize);
-				m_overallSize += unitSize;
+			m_recordSizes.assign(getBufferCount(), 0);
+			for(std::deque< std::shared_ptr<Varying> >::iterator it = m_varyings.begin(); it != m_varyings.end(); it++){
+				if(!(*it)->prepare(primitiveCount * m_maxOutputs, &unitSize))
+					return FAILURE;
+				(*it)->m_bufferOffset = m_recordSizes[(*it)->getBufferIndex()];
+				m_recordSizes[(*it)->getBufferIndex()] += unitSize;
 			}
+			resizeInterleavedBuffers((unsigned int)m_recordSizes.size());
 			m_prepared = true;
 		}
 
-		size_t bufSize = m_overallSize * primitiveCount;
-		if(bufSize != std::static_pointer_cast<InternalBuffer>(m_interleavedBuffer)->getSize() && bufSize != 0)
-			std::static_pointer_cast<InternalBuffer>(m_interleavedBuffer)->resize(bufSize);
+		for(unsigned int i = 0; i < m_interleavedBuffers.size(); i++){
+			std::shared_ptr<InternalBuffer> buffer = std::static_pointer_cast<InternalBuffer>(m_interleavedBuffers[i]);
+			buffer->setGrowthFactor(m_growthFactor);
+			buffer->reserve(m_recordSizes[i] * m_reservedCount * m_maxOutputs);
+
+			size_t bufSize = m_recordSizes[i] * primitiveCount * m_maxOutputs;
+			if(bufSize != buffer->getSize() && bufSize != 0 && !buffer->resize(bufSize))
+				return FAILURE;
+		}
 	}
 	else{
-		unsigned int i = 0;
-		for(std::deque< std::shared_ptr<Varying> >::iterator it = m_varyings.begin(); it != m_varyings.end(); it++, i++){
-			(*it)->prepare(i, primitiveCount);
+		for(std::deque< std::shared_ptr<Varying> >::iterator it = m_varyings.begin(); it != m_varyings.end(); it++){
+			if(!(*it)->prepare(primitiveCount * m_maxOutputs))
+				return FAILURE;
 		}
 	}
 
@@ -176,19 +340,14 @@ void ShaderOutput::activate(PrimitiveType primitiveType){
 	if(!m_active){
 		clearGLErrors();
 
-		m_primitivesProcessed = 0;
-
-		if(m_interleaved){
-			glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, m_interleavedBuffer->getGlID());
-			printGLError();
-		}
-		else{
-			unsigned int i = 0;
-			for(std::deque< std::shared_ptr<Varying> >::iterator it = m_varyings.begin(); it != m_varyings.end(); it++, i++){
-				glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, i, (*it)->getBuffer<void>()->getGlID());
-				printGLError();
-			}
+		//results of previous rendering are no longer needed
+		for(unsigned int i = 0; i < m_pendingQueries.size(); i++){
+			if(m_pendingQueries[i])
+				releaseQuery(m_pendingQueries[i]);
 		}
+		m_queryStreamCount = m_streamCount;
+		m_pendingQueries.assign(2*m_queryStreamCount, 0);
+		m_queryResults.assign(2*m_queryStreamCount, 0);
 	
 		GLenum primType = 0;
 		switch(primitiveType){
@@ -207,9 +366,19 @@ void ShaderOutput::activate(PrimitiveType primitiveType){
 			std::cerr << "ERROR: Invalid primitive type" << std::endl;
             return;
 		}
+
+		updateBindings();
         
-        glGenQueries(1, &m_query);
-        glBeginQuery(GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN, m_query);
+		//written primitives of each stream are followed by generated ones
+		m_queries.assign(m_queryStreamCount, 0);
+		for(unsigned int i = 0; i < m_queryStreamCount; i++){
+			m_queries[i] = acquireQuery();
+			if(m_queryStreamCount > 1)
+				glBeginQueryIndexed(GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN, i, m_queries[i]);
+			else
+				glBeginQuery(GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN, m_queries[i]);
+		}
+		beginGeneratedQueries();
 		printGLError();
 
 		glBeginTransformFeedback(primType);
@@ -223,25 +392,255 @@ bool ShaderOutput::isActive(){
 	return m_active;
 }
 
+bool ShaderOutput::pause(){
+	if(!m_active || m_paused)
+		return FAILURE;
+	if(!glewIsSupported("GL_ARB_transform_feedback2")){
+		std::cerr << "ERROR: Pausing transform feedback is not supported by graphics card" << std::endl;
+		return FAILURE;
+	}
+
+	clearGLErrors();
+
+	glPauseTransformFeedback();
+	if(printGLError())
+		return FAILURE;
+
+	//primitives are still generated while paused, so they are counted only between pauses
+	endGeneratedQueries();
+	printGLError();
+
+	m_paused = true;
+	return SUCCESS;
+}
+
+bool ShaderOutput::resume(){
+	if(!m_active || !m_paused)
+		return FAILURE;
+
+	clearGLErrors();
+
+	glResumeTransformFeedback();
+	if(printGLError())
+		return FAILURE;
+
+	beginGeneratedQueries();
+	printGLError();
+
+	m_paused = false;
+	return SUCCESS;
+}
+
+bool ShaderOutput::isPaused(){
+	return m_paused;
+}
+
 void ShaderOutput::deactivate(){
 	if(m_active){
 		clearGLErrors();
 
 		glEndTransformFeedback();
-		glEndQuery(GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN);
-		glGetQueryObjectiv(m_query, GL_QUERY_RESULT, &m_primitivesProcessed);
+		for(unsigned int i = 0; i < m_queryStreamCount; i++){
+			if(m_queryStreamCount > 1)
+				glEndQueryIndexed(GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN, i);
+			else
+				glEndQuery(GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN);
+		}
+		if(!m_paused)
+			endGeneratedQueries();
+		m_pendingQueries.swap(m_queries);
+		m_queries.clear();
+		m_queryResults.assign(m_pendingQueries.size(), 0);
+		m_paused = false;
 		printGLError();
 
-		if(m_interleaved){
-			glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+		if(m_feedbackID){
+			//buffers stay bound to feedback object
+			glBindTransformFeedback(GL_TRANSFORM_FEEDBACK, 0);
 			printGLError();
 		}
 		else{
-			for(unsigned int i = 0; i < m_varyings.size(); i++){
+			for(unsigned int i = 0; i < m_bindings.size(); i++)
 				glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, i, 0);
-				printGLError();
-			}
+			m_bindings.clear();
+			printGLError();
 		}
 		m_active = false;
 	}
 }
+
+unsigned int ShaderOutput::getFeedbackGlID(){
+	return m_feedbackID;
+}
+
+bool ShaderOutput::getPrimitivesWritten(unsigned int& count, bool wait, unsigned int stream){
+	count = 0;
+	if(stream >= m_queryStreamCount)
+		return FAILURE;
+	return getQueryResult(stream, count, wait);
+}
+
+bool ShaderOutput::getPrimitivesGenerated(unsigned int& count, bool wait, unsigned int stream){
+	count = 0;
+	if(stream >= m_queryStreamCount)
+		return FAILURE;
+	//sum generated primitives of all unpaused parts of recording
+	for(size_t i = m_queryStreamCount + stream; i < m_pendingQueries.size(); i += m_queryStreamCount){
+		unsigned int partCount = 0;
+		if(!getQueryResult((unsigned int)i, partCount, wait))
+			return FAILURE;
+		count += partCount;
+	}
+	return SUCCESS;
+}
+
+bool ShaderOutput::hasOverflowed(bool& overflow, bool wait){
+	overflow = false;
+	for(unsigned int i = 0; i < m_queryStreamCount && !m_pendingQueries.empty(); i++){
+		unsigned int written = 0, generated = 0;
+		if(!getPrimitivesWritten(written, wait, i) || !getPrimitivesGenerated(generated, wait, i))
+			return FAILURE;
+		if(generated > written)
+			overflow = true;
+	}
+	return m_pendingQueries.size() != 0;
+}
+
+void ShaderOutput::setMaxOutputsPerPrimitive(unsigned int count){
+	if(count == 0)
+		count = 1;
+	m_maxOutputs = count;
+}
+
+unsigned int ShaderOutput::getMaxOutputsPerPrimitive(){
+	return m_maxOutputs;
+}
+
+void ShaderOutput::setAutoGrow(bool autoGrow){
+	m_autoGrow = autoGrow;
+}
+
+bool ShaderOutput::isAutoGrow(){
+	return m_autoGrow;
+}
+
+bool ShaderOutput::getQueryResult(unsigned int index, unsigned int& count, bool wait){
+	//query was already read
+	if(!m_pendingQueries[index]){
+		count = m_queryResults[index];
+		return SUCCESS;
+	}
+
+	clearGLErrors();
+
+	if(!wait){
+		GLuint available = GL_FALSE;
+		glGetQueryObjectuiv(m_pendingQueries[index], GL_QUERY_RESULT_AVAILABLE, &available);
+		if(printGLError() || available == GL_FALSE)
+			return FAILURE;
+	}
+
+	glGetQueryObjectuiv(m_pendingQueries[index], GL_QUERY_RESULT, &m_queryResults[index]);
+	if(printGLError())
+		return FAILURE;
+
+	releaseQuery(m_pendingQueries[index]);
+	m_pendingQueries[index] = 0;
+
+	count = m_queryResults[index];
+	return SUCCESS;
+}
+
+unsigned int ShaderOutput::getQueryObjectCount(){
+	return m_queryCount;
+}
+
+void ShaderOutput::updateBindings(){
+	std::vector<FeedbackBinding> bindings;
+	if(m_interleaved){
+		for(unsigned int i = 0; i < m_interleavedBuffers.size(); i++)
+			bindings.push_back(FeedbackBinding(m_interleavedBuffers[i]->getGlID(), m_interleavedBuffers[i]->getStorageGeneration(), m_interleavedBuffers[i]->getStorageOffset(), m_interleavedBuffers[i]->getByteSize()));
+	}
+	else{
+		for(std::deque< std::shared_ptr<Varying> >::iterator it = m_varyings.begin(); it != m_varyings.end(); it++){
+			std::shared_ptr<const BufferBase> buffer = (*it)->getBuffer<void>();
+			bindings.push_back(FeedbackBinding(buffer->getGlID(), buffer->getStorageGeneration(), buffer->getStorageOffset(), buffer->getByteSize()));
+		}
+	}
+
+	clearGLErrors();
+
+	if(m_feedbackID == 0 && glewIsSupported("GL_ARB_transform_feedback2")){
+		glGenTransformFeedbacks(1, &m_feedbackID);
+		m_bindings.clear();
+	}
+
+	if(m_feedbackID)
+		glBindTransformFeedback(GL_TRANSFORM_FEEDBACK, m_feedbackID);
+
+	//feedback object remembers its bindings, so only changed ones are rebound,
+	//generation tells apart new storage that reuses identifier of deleted one
+	for(unsigned int i = 0; i < bindings.size(); i++){
+		if(i < m_bindings.size() && bindings[i] == m_bindings[i])
+			continue;
+
+		if(bindings[i].size != 0)
+			glBindBufferRange(GL_TRANSFORM_FEEDBACK_BUFFER, i, bindings[i].bufferID, bindings[i].offset, bindings[i].size);
+		else
+			glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, i, bindings[i].bufferID);
+	}
+	for(unsigned int i = (unsigned int)bindings.size(); i < m_bindings.size(); i++)
+		glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, i, 0);
+
+	m_bindings.swap(bindings);
+
+	printGLError();
+}
+
+void ShaderOutput::beginGeneratedQueries(){
+	for(unsigned int i = 0; i < m_queryStreamCount; i++){
+		unsigned int query = acquireQuery();
+		m_queries.push_back(query);
+		if(m_queryStreamCount > 1)
+			glBeginQueryIndexed(GL_PRIMITIVES_GENERATED, i, query);
+		else
+			glBeginQuery(GL_PRIMITIVES_GENERATED, query);
+	}
+}
+
+void ShaderOutput::endGeneratedQueries(){
+	for(unsigned int i = 0; i < m_queryStreamCount; i++){
+		if(m_queryStreamCount > 1)
+			glEndQueryIndexed(GL_PRIMITIVES_GENERATED, i);
+		else
+			glEndQuery(GL_PRIMITIVES_GENERATED);
+	}
+}
+
+void ShaderOutput::resizeInterleavedBuffers(unsigned int count){
+	while(m_interleavedBuffers.size() > count)
+		m_interleavedBuffers.pop_back();
+	while(m_interleavedBuffers.size() < count){
+		BufferBase::Ptr buffer(std::dynamic_pointer_cast<BufferBase>(InternalBuffer::create(m_arena)));
+		buffer->setFrequencyMode(BufferBase::FrequencyMode::DYNAMIC);
+		buffer->setNatureMode(BufferBase::NatureMode::COPY);
+		m_interleavedBuffers.push_back(buffer);
+	}
+}
+
+unsigned int ShaderOutput::acquireQuery(){
+	unsigned int query = 0;
+	if(!m_freeQueries.empty()){
+		query = m_freeQueries.back();
+		m_freeQueries.pop_back();
+	}
+	else{
+		glGenQueries(1, &query);
+		m_queryCount++;
+	}
+	return query;
+}
+
+void ShaderOutput::releaseQuery(unsigned int query){
+	m_freeQueries.push_back(query);
+}
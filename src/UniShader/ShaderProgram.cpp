@@ -35,10 +35,22 @@
 
 using UNISHADER_NAMESPACE;
 
+std::map<const void*, ShaderProgram*> ShaderProgram::m_boundPrograms;
+
+ShaderProgram::Statistics::Statistics():
+activations(0),
+boundActivations(0),
+estimatedCallsSkipped(0){
+
+}
+
 ShaderProgram::ShaderProgram():
 m_programObjectID(0),
 m_linkStatus(LinkStatus::NONE),
-m_active(false){
+m_active(false),
+m_keepBound(false),
+m_bound(false),
+m_boundContext(0){
 	m_input = std::shared_ptr<ShaderInput>(new ShaderInput(*this));
 	m_output = std::shared_ptr<ShaderOutput>(new ShaderOutput(*this));
 }
@@ -49,6 +61,8 @@ const std::string& ShaderProgram::getClassName() const{
 }
 
 ShaderProgram::~ShaderProgram(){;
+	release();
+	unbind();
 	clearGLErrors();
 
 	glDeleteProgram(m_programObjectID);
@@ -125,19 +139,19 @@ bool ShaderProgram::activate(){
 	if(!m_active){
 		clearGLErrors();
 
-		ensureLink();
+		if(!activateBound()){
+			ensureLink();
 	
-		m_input->prepare();
+			m_input->prepare();
 
-		glUseProgram(m_programObjectID);
-		if(printGLError()){
-			glUseProgram(0);
-			return FAILURE;
-		}
+			if(!useProgram())
+				return FAILURE;
 
-		m_input->activate();
+			m_input->activate();
+		}
 
 		m_active = true;
+		m_statistics.activations++;
 		return SUCCESS;
 	}
 	return FAILURE;
@@ -147,21 +161,27 @@ bool ShaderProgram::activate(PrimitiveType primitiveType, unsigned int primitive
 	if(!m_active){
 		clearGLErrors();
 
-		ensureLink();
+		//output that can't be recorded safely must not be activated
+		if(activateBound()){
+			if(!m_output->prepare(primitiveCount))
+				return FAILURE;
+		}
+		else{
+			ensureLink();
 	
-		m_input->prepare();
-		m_output->prepare(primitiveCount);
+			m_input->prepare();
+			if(!m_output->prepare(primitiveCount))
+				return FAILURE;
 
-		glUseProgram(m_programObjectID);
-		if(printGLError()){
-			glUseProgram(0);
-			return FAILURE;
-		}
+			if(!useProgram())
+				return FAILURE;
 
-		m_input->activate();
+			m_input->activate();
+		}
 		m_output->activate(primitiveType);
 
 		m_active = true;
+		m_statistics.activations++;
 		return SUCCESS;
 	}
 	return FAILURE;
@@ -171,21 +191,125 @@ bool ShaderProgram::isActive(){
 	return m_active;
 }
 
+bool ShaderProgram::update(){
+	if(!m_active)
+		return FAILURE;
+
+	clearGLErrors();
+
+	m_input->deactivate();
+	m_input->prepare();
+	m_input->activate();
+
+	return !printGLError();
+}
+
 bool ShaderProgram::deactivate(){
 	if(m_active){
 		clearGLErrors();
 
 		m_output->deactivate();
 
-		m_input->deactivate();
+		if(m_keepBound){
+			//leave program, VAO and textures bound for next activation,
+			//skipped calls are counted once the state is really reused
+			if(m_bound && m_boundContext != getCurrentContext())
+				unbind();
+			m_bound = true;
+			m_boundContext = getCurrentContext();
+			boundProgram() = this;
+		}
+		else{
+			m_input->deactivate();
 	
-		glUseProgram(0);
+			glUseProgram(0);
+			unbind();
+		}
 		m_active = false;
 		return !printGLError();
 	}
 	return FAILURE;
 }
 
+void ShaderProgram::setKeepBound(bool keepBound){
+	m_keepBound = keepBound;
+	if(!keepBound)
+		release();
+}
+
+bool ShaderProgram::isKeepBound(){
+	return m_keepBound;
+}
+
+void ShaderProgram::release(){
+	if(!m_bound || m_active)
+		return;
+
+	clearGLErrors();
+	m_input->deactivate();
+	glUseProgram(0);
+	printGLError();
+
+	unbind();
+}
+
+ShaderProgram::Statistics ShaderProgram::getStatistics() const{
+	return m_statistics;
+}
+
+void ShaderProgram::resetStatistics(){
+	m_statistics = Statistics();
+}
+
+bool ShaderProgram::activateBound(){
+	//relinked program must be bound again
+	if(m_linkStatus == LinkStatus::PENDING_LINK)
+		release();
+
+	if(!m_bound || m_boundContext != getCurrentContext() || boundProgram() != this)
+		return FAILURE;
+
+	//glUseProgram(0) on deactivation and glUseProgram on activation
+	m_statistics.estimatedCallsSkipped += 2 + m_input->refresh();
+	m_statistics.boundActivations++;
+	return SUCCESS;
+}
+
+void ShaderProgram::unbind(){
+	if(m_bound){
+		std::map<const void*, ShaderProgram*>::iterator it = m_boundPrograms.find(m_boundContext);
+		if(it != m_boundPrograms.end() && it->second == this)
+			m_boundPrograms.erase(it);
+	}
+	m_bound = false;
+	m_boundContext = 0;
+}
+
+const void* ShaderProgram::getCurrentContext(){
+#ifdef GLEW_MX
+	return glewGetContext();
+#else
+	return 0;
+#endif
+}
+
+ShaderProgram*& ShaderProgram::boundProgram(){
+	return m_boundPrograms[getCurrentContext()];
+}
+
+bool ShaderProgram::useProgram(){
+	//other program kept bound must release its state first
+	if(boundProgram() != 0 && boundProgram() != this)
+		boundProgram()->release();
+
+	glUseProgram(m_programObjectID);
+	if(printGLError()){
+		glUseProgram(0);
+		return FAILURE;
+	}
+	return SUCCESS;
+}
+
 bool ShaderProgram::handleSignal(unsigned int signalID, const ObjectBase* callerPtr){
 	if(callerPtr->getClassName() == "us::ShaderObject"){
 		switch(signalID){
@@ -0,0 +1,191 @@
+/*
+* UniShader - Interface for GPGPU and working with shader programs
+* Copyright (c) 2011-2013 Ivan Sevcik - ivan-sevcik@hotmail.com
+*
+* This software is provided 'as-is', without any express or
+* implied warranty. In no event will the authors be held
+* liable for any damages arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute
+* it freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented;
+*    you must not claim that you wrote the original software.
+*    If you use this software in a product, an acknowledgment
+*    in the product documentation would be appreciated but
+*    is not required.
+*
+* 2. Altered source versions must be plainly marked as such,
+*    and must not be misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any
+*    source distribution.
+*/
+
+#include <UniShader/StreamBuffer.h>
+#include <UniShader/Fence.h>
+#include <UniShader/OpenGL.h>
+
+#include <iostream>
+
+using UNISHADER_NAMESPACE;
+
+StreamBuffer::StreamBuffer():
+m_fences(0),
+m_persistentPtr(0),
+m_regionSize(0),
+m_regionCount(0),
+m_regionIndex(0),
+m_acquired(false){
+
+}
+
+const std::string& StreamBuffer::getClassName() const{
+	static const std::string name("us::StreamBuffer");
+	return name;
+}
+
+StreamBuffer::~StreamBuffer(){
+	clearGLErrors();
+
+	if(m_persistentPtr || m_acquired){
+		glBindBuffer(GL_ARRAY_BUFFER, getGlID());
+		glUnmapBuffer(GL_ARRAY_BUFFER);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+	delete[] m_fences;
+
+	printGLError();
+}
+
+StreamBuffer::Ptr StreamBuffer::create(size_t regionSize, unsigned int regionCount){
+	if(regionSize == 0 || regionCount == 0){
+		std::cerr << "ERROR: Stream buffer must have nonzero region size and count" << std::endl;
+		return 0;
+	}
+
+	Ptr ptr(new StreamBuffer);
+	if(ptr->getGlID() == 0 || !ptr->allocate(regionSize, regionCount))
+		return 0;
+
+	return ptr;
+}
+
+bool StreamBuffer::allocate(size_t regionSize, unsigned int regionCount){
+	size_t size = regionSize * regionCount;
+
+	if(glewIsSupported("GL_ARB_buffer_storage")){
+		if(!setPlainStorage(0, size, StorageFlags::MAP_WRITE | StorageFlags::PERSISTENT | StorageFlags::COHERENT))
+			return FAILURE;
+
+		GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+		clearGLErrors();
+
+		glBindBuffer(GL_ARRAY_BUFFER, getGlID());
+		m_persistentPtr = (char*)glMapBufferRange(GL_ARRAY_BUFFER, 0, size, flags);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+		if(printGLError() || !m_persistentPtr){
+			std::cerr << "ERROR: Failed to map stream buffer persistently" << std::endl;
+			m_persistentPtr = 0;
+			return FAILURE;
+		}
+	}
+	else{
+		setFrequencyMode(FrequencyMode::STREAM);
+		setNatureMode(NatureMode::DRAW);
+		if(!setPlainData(0, size))
+			return FAILURE;
+	}
+
+	m_fences = new Fence[regionCount];
+	m_regionSize = regionSize;
+	m_regionCount = regionCount;
+	//first acquire advances to region 0
+	m_regionIndex = regionCount - 1;
+
+	return SUCCESS;
+}
+
+void* StreamBuffer::acquireRegion(){
+	if(m_acquired && !releaseRegion())
+		return 0;
+
+	//rendering commands using current region were already issued
+	m_fences[m_regionIndex].insert();
+
+	//advance only when next region is free, so that failed acquire can be retried
+	unsigned int next = (m_regionIndex + 1) % m_regionCount;
+	if(!m_fences[next].wait()){
+		std::cerr << "ERROR: Region of stream buffer is still in use" << std::endl;
+		return 0;
+	}
+	m_regionIndex = next;
+
+	if(m_persistentPtr){
+		m_acquired = true;
+		return m_persistentPtr + getRegionOffset();
+	}
+
+	clearGLErrors();
+
+	glBindBuffer(GL_ARRAY_BUFFER, getGlID());
+	void* ptr = glMapBufferRange(GL_ARRAY_BUFFER, getRegionOffset(), m_regionSize, 
+		GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	if(printGLError() || !ptr){
+		std::cerr << "ERROR: Failed to map region of stream buffer" << std::endl;
+		return 0;
+	}
+
+	m_acquired = true;
+	return ptr;
+}
+
+bool StreamBuffer::releaseRegion(){
+	if(!m_acquired)
+		return SUCCESS;
+
+	m_acquired = false;
+
+	//coherent mapping doesn't need explicit flush
+	if(m_persistentPtr)
+		return SUCCESS;
+
+	clearGLErrors();
+
+	glBindBuffer(GL_ARRAY_BUFFER, getGlID());
+	glUnmapBuffer(GL_ARRAY_BUFFER);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	return !printGLError();
+}
+
+unsigned int StreamBuffer::getRegionIndex() const{
+	return m_regionIndex;
+}
+
+unsigned int StreamBuffer::getRegionCount() const{
+	return m_regionCount;
+}
+
+size_t StreamBuffer::getRegionSize() const{
+	return m_regionSize;
+}
+
+size_t StreamBuffer::getRegionOffset() const{
+	return m_regionIndex * m_regionSize;
+}
+
+unsigned int StreamBuffer::getRegionElementOffset(size_t elementSize) const{
+	if(elementSize == 0)
+		return 0;
+	return (unsigned int)(getRegionOffset() / elementSize);
+}
+
+bool StreamBuffer::isPersistent() const{
+	return m_persistentPtr != 0;
+}
@@ -265,7 +265,11 @@ bool TextureBuffer::prepare(){
 		}
 
 		if(m_buffer){
-			glTexBuffer(GL_TEXTURE_BUFFER, internalFormat, m_buffer->getGlID());
+			//shared storage must be limited to buffer's own range
+			if(!m_buffer->ownsStorage())
+				glTexBufferRange(GL_TEXTURE_BUFFER, internalFormat, m_buffer->getGlID(), m_buffer->getStorageOffset(), m_buffer->getByteSize());
+			else
+				glTexBuffer(GL_TEXTURE_BUFFER, internalFormat, m_buffer->getGlID());
 			glBindTexture(GL_TEXTURE_BUFFER, 0);
 			m_prepared = true;
 		}
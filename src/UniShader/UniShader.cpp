@@ -26,6 +26,8 @@
 #include <UniShader/UniShader.h>
 #include <UniShader/OpenGL.h>
 
+#include <limits>
+
 using UNISHADER_NAMESPACE;
 
 //TODO: for whole application, querry max values
@@ -38,7 +40,10 @@ using UNISHADER_NAMESPACE;
 //and also those enum classes, but they will be introduced in VS11 so we for now we are using ugly classes
 
 UniShader::UniShader():
-m_program(0){
+m_program(0),
+m_recording(false),
+m_canPause(false),
+m_computeOnly(false){
 
 }
 
@@ -55,9 +60,53 @@ ShaderProgram::Ptr UniShader::program()
 }
 
 void UniShader::disconnectProgram(){
+	if(m_recording)
+		endRecording();
+	if(m_program)
+		m_program->release();
 	m_program = 0;
 }
 
+bool UniShader::beginRecording(PrimitiveType primitiveType, unsigned int capacity){
+	if(!m_program){
+		std::cerr << "ERROR: No shader program connected." << std::endl;
+		return FAILURE;
+	}
+	if(m_recording){
+		std::cerr << "ERROR: Recording is already in progress." << std::endl;
+		return FAILURE;
+	}
+	clearGLErrors();
+
+	if(!m_program->activate(primitiveType, capacity))
+		return FAILURE;
+
+	//keep output paused between renderings, so that state can change freely
+	m_canPause = glewIsSupported("GL_ARB_transform_feedback2") != 0;
+	if(m_canPause)
+		m_program->getOutput()->pause();
+
+	m_recording = true;
+	return !printGLError();
+}
+
+bool UniShader::isRecording(){
+	return m_recording;
+}
+
+unsigned int UniShader::endRecording(){
+	if(!m_recording){
+		std::cerr << "ERROR: No recording is in progress." << std::endl;
+		return 0;
+	}
+	m_program->deactivate();
+	m_recording = false;
+
+	unsigned int count = 0;
+	m_program->getOutput()->getPrimitivesWritten(count, true);
+	return count;
+}
+
 void UniShader::render(PrimitiveType primitiveType, unsigned int primitiveCount, unsigned int offset, bool record, bool wait){
 	if(!m_program){
 		std::cerr << "ERROR: No shader program connected." << std::endl;
@@ -66,42 +115,61 @@ void UniShader::render(PrimitiveType primitiveType, unsigned int primitiveCount,
 	clearGLErrors();
 
 	GLenum mode;
-	
-	switch(primitiveType){
-	case PrimitiveType::POINTS:
-		mode = GL_POINTS;
-		break;
-	case PrimitiveType::LINES:
-		mode = GL_LINES;
-		break;
-	case PrimitiveType::LINE_STRIP:
-		mode = GL_LINE_STRIP;
-		break;
-    case PrimitiveType::LINE_STRIP_ADJACENCY:
-        mode = GL_LINE_STRIP_ADJACENCY;
-        break;
-	case PrimitiveType::TRIANGLES:
-		mode = GL_TRIANGLES;
-		break;
-	case PrimitiveType::TRIANGLE_STRIP:
-		mode = GL_TRIANGLE_STRIP;
-		break;
-	default:
-		std::cerr << "ERROR: Invalid primitive type" << std::endl;
+	if(!getDrawMode(primitiveType, mode))
+		return;
+
+	unsigned int attempt = 0;
+	do{
+		if(!beginDraw(primitiveType, primitiveCount, record))
+			return;
+
+		glDrawArrays(mode, offset, primitiveCount);
+
+		if(wait)
+			glFinish();
+		printGLError();
+		endDraw(record);
+	} while(record && shouldRerun(attempt++));
+}
+
+void UniShader::renderInstanced(PrimitiveType primitiveType, unsigned int primitiveCount, unsigned int instanceCount, unsigned int baseInstance, unsigned int offset, bool record, bool wait){
+	if(!m_program){
+		std::cerr << "ERROR: No shader program connected." << std::endl;
 		return;
 	}
+	bool coreInstanced = glewIsSupported("GL_VERSION_3_1") != 0;
+	if(!coreInstanced && !glewIsSupported("GL_ARB_draw_instanced")){
+		std::cerr << "ERROR: Instanced rendering isn't supported by graphics card." << std::endl;
+		return;
+	}
+	if(baseInstance != 0 && !glewIsSupported("GL_ARB_base_instance")){
+		std::cerr << "ERROR: Base instance isn't supported by graphics card." << std::endl;
+		return;
+	}
+	clearGLErrors();
 
-	if(record)
-		m_program->activate(primitiveType, primitiveCount);
-	else
-		m_program->activate();
+	GLenum mode;
+	if(!getDrawMode(primitiveType, mode))
+		return;
 
-	glDrawArrays(mode, offset, primitiveCount);
+	unsigned int attempt = 0;
+	do{
+		//every instance is recorded after previous one
+		if(!beginDraw(primitiveType, primitiveCount * instanceCount, record))
+			return;
 
-	if(wait)
-		glFinish();
-	printGLError();
-	m_program->deactivate();
+		if(baseInstance == 0 && coreInstanced)
+			glDrawArraysInstanced(mode, offset, primitiveCount, instanceCount);
+		else if(baseInstance == 0)
+			glDrawArraysInstancedARB(mode, offset, primitiveCount, instanceCount);
+		else
+			glDrawArraysInstancedBaseInstance(mode, offset, primitiveCount, instanceCount, baseInstance);
+
+		if(wait)
+			glFinish();
+		printGLError();
+		endDraw(record);
+	} while(record && shouldRerun(attempt++));
 }
 
 void UniShader::renderElements(Buffer<unsigned int>::Ptr elementsBuffer, PrimitiveType primitiveType, unsigned int primitiveCount, unsigned int offset, bool record, bool wait){
@@ -112,7 +180,243 @@ void UniShader::renderElements(Buffer<unsigned int>::Ptr elementsBuffer, Primiti
 	clearGLErrors();
 
 	GLenum mode;
-	
+	if(!getDrawMode(primitiveType, mode))
+		return;
+
+	unsigned int attempt = 0;
+	do{
+		if(!beginDraw(primitiveType, primitiveCount, record))
+			return;
+
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, elementsBuffer->getGlID());
+		glDrawRangeElements(mode, offset, offset + primitiveCount, primitiveCount, GL_UNSIGNED_INT, 0);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+		if(wait)
+			glFinish();
+		printGLError();
+		endDraw(record);
+	} while(record && shouldRerun(attempt++));
+}
+
+bool UniShader::renderMulti(PrimitiveType primitiveType, const std::vector<int>& firsts, const std::vector<int>& counts, bool record, bool wait){
+	if(!m_program){
+		std::cerr << "ERROR: No shader program connected." << std::endl;
+		return FAILURE;
+	}
+	if(firsts.size() != counts.size()){
+		std::cerr << "ERROR: Number of firsts and counts doesn't match." << std::endl;
+		return FAILURE;
+	}
+	if(firsts.empty()){
+		std::cerr << "ERROR: No ranges to render." << std::endl;
+		return FAILURE;
+	}
+	if(counts.size() > (size_t)std::numeric_limits<GLsizei>::max()){
+		std::cerr << "ERROR: Too many ranges to render." << std::endl;
+		return FAILURE;
+	}
+
+	//outputs of all draws are recorded one after another
+	unsigned int primitiveCount = 0;
+	for(size_t i = 0; i < counts.size(); i++){
+		if(firsts[i] < 0 || counts[i] < 0){
+			std::cerr << "ERROR: Range " << i << " has negative first or count." << std::endl;
+			return FAILURE;
+		}
+		if((unsigned int)counts[i] > std::numeric_limits<unsigned int>::max() - primitiveCount){
+			std::cerr << "ERROR: Total count of rendered vertices is too big." << std::endl;
+			return FAILURE;
+		}
+		primitiveCount += (unsigned int)counts[i];
+	}
+	clearGLErrors();
+
+	GLenum mode;
+	if(!getDrawMode(primitiveType, mode))
+		return FAILURE;
+
+	bool success = SUCCESS;
+	unsigned int attempt = 0;
+	do{
+		if(!beginDraw(primitiveType, primitiveCount, record))
+			return FAILURE;
+
+		glMultiDrawArrays(mode, &firsts[0], &counts[0], (GLsizei)counts.size());
+
+		if(wait)
+			glFinish();
+		success = !printGLError();
+		endDraw(record);
+	} while(record && shouldRerun(attempt++));
+	return success;
+}
+
+bool UniShader::renderIndirect(Buffer<DrawArraysIndirectCommand>::Ptr commands, PrimitiveType primitiveType, unsigned int drawCount, unsigned int capacity, unsigned int commandOffset, bool record, bool wait){
+	if(!m_program){
+		std::cerr << "ERROR: No shader program connected." << std::endl;
+		return FAILURE;
+	}
+	if(!commands){
+		std::cerr << "ERROR: No command buffer passed." << std::endl;
+		return FAILURE;
+	}
+	if(!glewIsSupported("GL_ARB_draw_indirect")){
+		std::cerr << "ERROR: Indirect rendering isn't supported by graphics card." << std::endl;
+		return FAILURE;
+	}
+	if(!checkCommandRange(commands->getByteSize(), sizeof(DrawArraysIndirectCommand), drawCount, commandOffset))
+		return FAILURE;
+	clearGLErrors();
+
+	GLenum mode;
+	if(!getDrawMode(primitiveType, mode))
+		return FAILURE;
+
+	size_t offset = commands->getStorageOffset() + commandOffset * sizeof(DrawArraysIndirectCommand);
+	bool multiDraw = glewIsSupported("GL_ARB_multi_draw_indirect") != 0;
+
+	bool success = SUCCESS;
+	unsigned int attempt = 0;
+	do{
+		if(!beginDraw(primitiveType, capacity, record))
+			return FAILURE;
+
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commands->getGlID());
+		if(multiDraw)
+			glMultiDrawArraysIndirect(mode, (void*)offset, (GLsizei)drawCount, 0);
+		else{
+			for(unsigned int i = 0; i < drawCount; i++)
+				glDrawArraysIndirect(mode, (void*)(offset + i * sizeof(DrawArraysIndirectCommand)));
+		}
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+		if(wait)
+			glFinish();
+		success = !printGLError();
+		endDraw(record);
+	} while(record && shouldRerun(attempt++));
+	return success;
+}
+
+bool UniShader::renderElementsIndirect(Buffer<unsigned int>::Ptr elementsBuffer, Buffer<DrawElementsIndirectCommand>::Ptr commands, PrimitiveType primitiveType, unsigned int drawCount, unsigned int capacity, unsigned int commandOffset, bool record, bool wait){
+	if(!m_program){
+		std::cerr << "ERROR: No shader program connected." << std::endl;
+		return FAILURE;
+	}
+	if(!elementsBuffer || !commands){
+		std::cerr << "ERROR: No element or command buffer passed." << std::endl;
+		return FAILURE;
+	}
+	if(!glewIsSupported("GL_ARB_draw_indirect")){
+		std::cerr << "ERROR: Indirect rendering isn't supported by graphics card." << std::endl;
+		return FAILURE;
+	}
+	if(!checkCommandRange(commands->getByteSize(), sizeof(DrawElementsIndirectCommand), drawCount, commandOffset))
+		return FAILURE;
+	clearGLErrors();
+
+	GLenum mode;
+	if(!getDrawMode(primitiveType, mode))
+		return FAILURE;
+
+	size_t offset = commands->getStorageOffset() + commandOffset * sizeof(DrawElementsIndirectCommand);
+	bool multiDraw = glewIsSupported("GL_ARB_multi_draw_indirect") != 0;
+
+	bool success = SUCCESS;
+	unsigned int attempt = 0;
+	do{
+		if(!beginDraw(primitiveType, capacity, record))
+			return FAILURE;
+
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, elementsBuffer->getGlID());
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commands->getGlID());
+		if(multiDraw)
+			glMultiDrawElementsIndirect(mode, GL_UNSIGNED_INT, (void*)offset, (GLsizei)drawCount, 0);
+		else{
+			for(unsigned int i = 0; i < drawCount; i++)
+				glDrawElementsIndirect(mode, GL_UNSIGNED_INT, (void*)(offset + i * sizeof(DrawElementsIndirectCommand)));
+		}
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+		if(wait)
+			glFinish();
+		success = !printGLError();
+		endDraw(record);
+	} while(record && shouldRerun(attempt++));
+	return success;
+}
+
+void UniShader::renderFeedback(ShaderOutput::Ptr source, PrimitiveType primitiveType, unsigned int capacity, unsigned int stream, bool record, bool wait){
+	if(!m_program){
+		std::cerr << "ERROR: No shader program connected." << std::endl;
+		return;
+	}
+	if(!source){
+		std::cerr << "ERROR: No source shader output passed." << std::endl;
+		return;
+	}
+	if(&(*source) == &(*m_program->getOutput())){
+		std::cerr << "ERROR: Shader program can't render its own output." << std::endl;
+		return;
+	}
+	if(source->getFeedbackGlID() == 0){
+		std::cerr << "ERROR: Source shader output has nothing recorded or transform feedback objects aren't supported." << std::endl;
+		return;
+	}
+	if(stream != 0 && !glewIsSupported("GL_ARB_transform_feedback3")){
+		std::cerr << "ERROR: Multiple transform feedback streams aren't supported by graphics card." << std::endl;
+		return;
+	}
+	clearGLErrors();
+
+	GLenum mode;
+	if(!getDrawMode(primitiveType, mode))
+		return;
+
+	unsigned int attempt = 0;
+	do{
+		if(!beginDraw(primitiveType, capacity, record))
+			return;
+
+		if(stream == 0)
+			glDrawTransformFeedback(mode, source->getFeedbackGlID());
+		else
+			glDrawTransformFeedbackStream(mode, source->getFeedbackGlID(), stream);
+
+		if(wait)
+			glFinish();
+		printGLError();
+		endDraw(record);
+	} while(record && shouldRerun(attempt++));
+}
+
+void UniShader::setComputeOnly(bool computeOnly){
+	m_computeOnly = computeOnly;
+}
+
+bool UniShader::isComputeOnly(){
+	return m_computeOnly;
+}
+
+bool UniShader::checkCommandRange(size_t bufferSize, size_t commandSize, unsigned int drawCount, unsigned int commandOffset){
+	if(drawCount == 0){
+		std::cerr << "ERROR: No commands to render." << std::endl;
+		return FAILURE;
+	}
+	if(drawCount > (unsigned int)std::numeric_limits<GLsizei>::max()){
+		std::cerr << "ERROR: Too many commands to render." << std::endl;
+		return FAILURE;
+	}
+	if((size_t)commandOffset + drawCount > bufferSize / commandSize){
+		std::cerr << "ERROR: Commands exceed size of command buffer." << std::endl;
+		return FAILURE;
+	}
+	return SUCCESS;
+}
+
+bool UniShader::getDrawMode(PrimitiveType primitiveType, unsigned int& mode){
 	switch(primitiveType){
 	case PrimitiveType::POINTS:
 		mode = GL_POINTS;
@@ -134,22 +438,80 @@ void UniShader::renderElements(Buffer<unsigned int>::Ptr elementsBuffer, Primiti
 		break;
 	default:
 		std::cerr << "ERROR: Invalid primitive type" << std::endl;
-		return;
+		return FAILURE;
+	}
+	return SUCCESS;
+}
+
+bool UniShader::beginDraw(PrimitiveType primitiveType, unsigned int primitiveCount, bool record){
+	if(!m_recording){
+		bool activated = record ? m_program->activate(primitiveType, primitiveCount) : m_program->activate();
+		if(!activated){
+			std::cerr << "ERROR: Failed to activate shader program." << std::endl;
+			return FAILURE;
+		}
 	}
+	else{
+		if(!record && !m_canPause){
+			std::cerr << "ERROR: Rendering without recording during recording session requires ARB_transform_feedback2." << std::endl;
+			return FAILURE;
+		}
 
-	if(record)
-		m_program->activate(primitiveType, primitiveCount);
-	else
-		m_program->activate();
+		m_program->update();
 
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, elementsBuffer->getGlID());
-	glDrawRangeElements(mode, offset, offset + primitiveCount, primitiveCount, GL_UNSIGNED_INT, 0);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+		ShaderOutput::Ptr output = m_program->getOutput();
+		if(record && output->isPaused() && !output->resume()){
+			std::cerr << "ERROR: Failed to resume recording." << std::endl;
+			return FAILURE;
+		}
+	}
 
-	if(wait)
-		glFinish();
-	printGLError();
-	m_program->deactivate();
+	//only recorded values are wanted, so skip rasterization and fragment stage,
+	//enabled last so that failed draw leaves it disabled
+	if(m_computeOnly)
+		glEnable(GL_RASTERIZER_DISCARD);
+	return SUCCESS;
+}
+
+void UniShader::endDraw(bool record){
+	if(!m_recording)
+		m_program->deactivate();
+	else if(record && m_canPause)
+		m_program->getOutput()->pause();
+
+	if(m_computeOnly)
+		glDisable(GL_RASTERIZER_DISCARD);
+}
+
+bool UniShader::shouldRerun(unsigned int attempt){
+	static const unsigned int maxAttempts = 4;
+
+	if(m_recording)
+		return false;
+
+	ShaderOutput::Ptr output = m_program->getOutput();
+	if(!output->isAutoGrow() || attempt >= maxAttempts)
+		return false;
+
+	bool overflow = false;
+	if(!output->hasOverflowed(overflow, true) || !overflow)
+		return false;
+
+	//grow by ratio of generated and written primitives, at least twice
+	unsigned int maxOutputs = output->getMaxOutputsPerPrimitive();
+	unsigned int newMaxOutputs = maxOutputs * 2;
+	for(unsigned int i = 0; i < output->getStreamCount(); i++){
+		unsigned int written = 0, generated = 0;
+		output->getPrimitivesWritten(written, true, i);
+		output->getPrimitivesGenerated(generated, true, i);
+		if(written != 0){
+			unsigned int required = (maxOutputs * generated + written - 1) / written;
+			if(required > newMaxOutputs)
+				newMaxOutputs = required;
+		}
+	}
+	output->setMaxOutputsPerPrimitive(newMaxOutputs);
+	return true;
 }
 
 #ifdef GLEW_MX
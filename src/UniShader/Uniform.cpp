@@ -517,6 +517,20 @@ void Uniform::apply(){
 	m_applied = true;
 }
 
+bool Uniform::needsApply() const{
+	return !m_prepared || !m_applied;
+}
+
+unsigned int Uniform::estimateRebindCallCount() const{
+	//unit activation, texture bind and sampler value, texture buffer is also unbound
+	if(m_textureBuffer)
+		return 5;
+	if(m_texture)
+		return 3;
+	//values aren't set again once applied
+	return 0;
+}
+
 void Uniform::deactivateTextureSource(){
 	if(m_textureBuffer)
 		m_textureBuffer->deactivate();
@@ -0,0 +1,249 @@
+/*
+* UniShader - Interface for GPGPU and working with shader programs
+* Copyright (c) 2011-2013 Ivan Sevcik - ivan-sevcik@hotmail.com
+*
+* This software is provided 'as-is', without any express or
+* implied warranty. In no event will the authors be held
+* liable for any damages arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute
+* it freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented;
+*    you must not claim that you wrote the original software.
+*    If you use this software in a product, an acknowledgment
+*    in the product documentation would be appreciated but
+*    is not required.
+*
+* 2. Altered source versions must be plainly marked as such,
+*    and must not be misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any
+*    source distribution.
+*/
+
+#include <UniShader/UploadBatch.h>
+#include <UniShader/OpenGL.h>
+
+#include <iostream>
+#include <cstring>
+
+using UNISHADER_NAMESPACE;
+
+UploadBatch::Statistics::Statistics():
+flushCount(0),
+uploadCount(0),
+uploadedBytes(0),
+bytesSaved(0),
+callsIssued(0),
+callsSaved(0){
+
+}
+
+UploadBatch::UploadBatch():
+m_stagingID(0),
+m_stagingSize(0){
+	clearGLErrors();
+
+	glGenBuffers(1, &m_stagingID);
+	printGLError();
+}
+
+const std::string& UploadBatch::getClassName() const{
+	static const std::string name("us::UploadBatch");
+	return name;
+}
+
+UploadBatch::~UploadBatch(){
+	clearGLErrors();
+
+	glDeleteBuffers(1, &m_stagingID);
+	printGLError();
+}
+
+UploadBatch::Ptr UploadBatch::create(){
+	Ptr ptr(new UploadBatch);
+	if(ptr->m_stagingID == 0)
+		return 0;
+	return ptr;
+}
+
+bool UploadBatch::addPlainData(BufferBase::Ptr buffer, const void* data, size_t offset, size_t size, bool resize){
+	if(!buffer){
+		std::cerr << "ERROR: Passed buffer is NULL" << std::endl;
+		return FAILURE;
+	}
+	if(data == 0){
+		std::cerr << "ERROR: Passed pointer is NULL" << std::endl;
+		return FAILURE;
+	}
+
+	//whole buffer is replaced, so pending uploads to it are useless
+	if(resize){
+		bool erased = false;
+		std::vector<Upload>::iterator it = m_uploads.begin();
+		while(it != m_uploads.end()){
+			if(it->buffer == buffer){
+				m_statistics.bytesSaved += it->size;
+				it = m_uploads.erase(it);
+				erased = true;
+			}
+			else
+				it++;
+		}
+		if(erased)
+			compactData();
+	}
+
+	Upload upload;
+	upload.buffer = buffer;
+	upload.dataOffset = m_data.size();
+	upload.offset = offset;
+	upload.size = size;
+	upload.resize = resize;
+
+	try{
+		m_data.resize(m_data.size() + size);
+		m_uploads.push_back(upload);
+	}
+	catch(...){
+		std::cerr << "ERROR: Failed to allocate memory for data" << std::endl;
+		return FAILURE;
+	}
+
+	if(size != 0)
+		memcpy(&m_data[upload.dataOffset], data, size);
+	return SUCCESS;
+}
+
+void UploadBatch::compactData(){
+	//uploads are kept in order of their data, so they can be moved towards the beginning in place
+	size_t dataOffset = 0;
+	for(std::vector<Upload>::iterator it = m_uploads.begin(); it != m_uploads.end(); it++){
+		if(it->dataOffset != dataOffset && it->size != 0)
+			memmove(&m_data[dataOffset], &m_data[it->dataOffset], it->size);
+		it->dataOffset = dataOffset;
+		dataOffset += it->size;
+	}
+	m_data.resize(dataOffset);
+}
+
+bool UploadBatch::flush(){
+	if(m_uploads.empty()){
+		discard();
+		return SUCCESS;
+	}
+
+	bool result = SUCCESS;
+
+	//reallocate buffers that change size and drop uploads that don't fit
+	size_t stagingSize = 0;
+	std::vector<Upload>::iterator it = m_uploads.begin();
+	while(it != m_uploads.end()){
+		if(it->resize && it->buffer->getByteSize() != it->size){
+			if(!it->buffer->setPlainData(0, it->size)){
+				result = FAILURE;
+				it = m_uploads.erase(it);
+				continue;
+			}
+		}
+		else if(it->offset + it->size > it->buffer->getByteSize()){
+			std::cerr << "ERROR: Data exceed size of buffer" << std::endl;
+			result = FAILURE;
+			it = m_uploads.erase(it);
+			continue;
+		}
+		stagingSize += it->size;
+		it++;
+	}
+
+	if(m_uploads.empty()){
+		discard();
+		return result;
+	}
+
+	unsigned int calls = 0;
+
+	clearGLErrors();
+
+	glBindBuffer(GL_COPY_READ_BUFFER, m_stagingID);
+	calls++;
+	if(stagingSize > m_stagingSize){
+		glBufferData(GL_COPY_READ_BUFFER, stagingSize, 0, GL_STREAM_DRAW);
+		m_stagingSize = stagingSize;
+		calls++;
+	}
+
+	char* mappedPtr = (char*)glMapBufferRange(GL_COPY_READ_BUFFER, 0, stagingSize, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+	calls++;
+	if(!mappedPtr){
+		std::cerr << "ERROR: Failed to map staging buffer" << std::endl;
+		glBindBuffer(GL_COPY_READ_BUFFER, 0);
+		printGLError();
+		discard();
+		return FAILURE;
+	}
+
+	//pack live uploads into staging buffer
+	size_t stagingOffset = 0;
+	for(it = m_uploads.begin(); it != m_uploads.end(); it++){
+		memcpy(mappedPtr + stagingOffset, &m_data[it->dataOffset], it->size);
+		it->dataOffset = stagingOffset;
+		stagingOffset += it->size;
+	}
+
+	glUnmapBuffer(GL_COPY_READ_BUFFER);
+	calls++;
+
+	unsigned int boundID = 0;
+	for(it = m_uploads.begin(); it != m_uploads.end(); it++){
+		if(it->buffer->getGlID() != boundID){
+			boundID = it->buffer->getGlID();
+			glBindBuffer(GL_COPY_WRITE_BUFFER, boundID);
+			calls++;
+		}
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, it->dataOffset, it->buffer->getStorageOffset() + it->offset, it->size);
+		calls++;
+	}
+
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+	calls += 2;
+
+	if(printGLError())
+		result = FAILURE;
+
+	//separate upload costs bind, upload and unbind
+	unsigned int separateCalls = 3 * (unsigned int)m_uploads.size();
+
+	m_statistics.flushCount++;
+	m_statistics.uploadCount += (unsigned int)m_uploads.size();
+	m_statistics.uploadedBytes += stagingSize;
+	m_statistics.callsIssued += calls;
+	if(separateCalls > calls)
+		m_statistics.callsSaved += separateCalls - calls;
+
+	discard();
+	return result;
+}
+
+void UploadBatch::discard(){
+	m_uploads.clear();
+	m_data.clear();
+}
+
+unsigned int UploadBatch::getPendingCount() const{
+	return (unsigned int)m_uploads.size();
+}
+
+size_t UploadBatch::getPendingBytes() const{
+	size_t size = 0;
+	for(std::vector<Upload>::const_iterator it = m_uploads.begin(); it != m_uploads.end(); it++)
+		size += it->size;
+	return size;
+}
+
+UploadBatch::Statistics UploadBatch::getStatistics() const{
+	return m_statistics;
+}
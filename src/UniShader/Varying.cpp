@@ -31,6 +31,7 @@
 #include <UniShader/TypeResolver.h>
 #include <UniShader/InternalBuffer.h>
 #include <string.h>
+#include <stdlib.h>
 
 using UNISHADER_NAMESPACE;
 
@@ -39,15 +40,15 @@ m_program(program),
 m_output(output),
 m_name(name),
 m_buffer(0),
+m_connectedBuffer(0),
 m_unitSize(0),
+m_bufferIndex(0),
+m_bufferOffset(0),
 m_prepared(false){
 	m_program.subscribeReceiver(signalPtr);
 	m_output.subscribeReceiver(signalPtr);
-	if(!m_output.isInterleaved()){
-		m_buffer = BufferBase::Ptr(std::dynamic_pointer_cast<BufferBase>(InternalBuffer::create()));
-		m_buffer->setFrequencyMode(BufferBase::FrequencyMode::DYNAMIC);
-		m_buffer->setNatureMode(BufferBase::NatureMode::COPY);
-	}
+	if(!m_output.isInterleaved())
+		createBuffer();
 }
 
 const std::string& Varying::getClassName() const{
@@ -67,7 +68,37 @@ std::string Varying::getName() const{
 	return m_name;
 }
 
-bool Varying::prepare(unsigned int index, unsigned int primitiveCount, size_t* unitSize){
+unsigned int Varying::getBufferIndex() const{
+	return m_bufferIndex;
+}
+
+size_t Varying::getBufferOffset() const{
+	return m_bufferOffset;
+}
+
+size_t Varying::getBufferStride() const{
+	if(m_output.isInterleaved() && m_bufferIndex < m_output.m_recordSizes.size())
+		return m_output.m_recordSizes[m_bufferIndex];
+	return m_unitSize;
+}
+
+bool Varying::isPadding() const{
+	return m_name.compare(0, 17, "gl_SkipComponents") == 0;
+}
+
+void Varying::connectBuffer(BufferBase::Ptr buffer){
+	if(m_output.isInterleaved()){
+		std::cerr << "ERROR: Buffer can't be connected to varying in interleaved mode" << std::endl;
+		return;
+	}
+	m_connectedBuffer = buffer;
+}
+
+void Varying::disconnectBuffer(){
+	m_connectedBuffer = 0;
+}
+
+bool Varying::prepare(unsigned int primitiveCount, size_t* unitSize){
 	size_t bufSize = 0;
 
 	if(m_program.getLinkStatus() != ShaderProgram::LinkStatus::SUCCESSFUL_LINK){
@@ -75,6 +106,20 @@ bool Varying::prepare(unsigned int index, unsigned int primitiveCount, size_t* u
 		return FAILURE;
 	}
 
+	if(!m_prepared && isPadding()){
+		if(!m_output.isInterleaved()){
+			std::cerr << "ERROR: " << m_name << " can be used only in interleaved mode" << std::endl;
+			return FAILURE;
+		}
+		int components = atoi(m_name.c_str() + 17);
+		if(components < 1 || components > 4){
+			std::cerr << "ERROR: Invalid padding " << m_name << std::endl;
+			return FAILURE;
+		}
+		m_unitSize = components * sizeof(GLfloat);
+		m_prepared = true;
+	}
+
 	if(!m_prepared){
 		GLsizei charSize = m_name.size()+1, size = 0, length = 0;
 		GLenum type = 0;
@@ -83,8 +128,10 @@ bool Varying::prepare(unsigned int index, unsigned int primitiveCount, size_t* u
 
 		GLint varyingCount;
 		glGetProgramiv(m_program.getGlID(), GL_TRANSFORM_FEEDBACK_VARYINGS, &varyingCount);
-		for(int i = 0; i < varyingCount; i++){
-			glGetTransformFeedbackVarying(m_program.getGlID(), index, charSize+1, &length, &size, &type, name);
+		//varyings can be reordered by buffers and mixed with gl_NextBuffer, so search by name
+		int i = 0;
+		for(; i < varyingCount; i++){
+			glGetTransformFeedbackVarying(m_program.getGlID(), i, charSize, &length, &size, &type, name);
 			if(length == m_name.size()){
 				//if names match break search
 				if(memcmp(name, m_name.c_str(), length) == 0)
@@ -94,7 +141,7 @@ bool Varying::prepare(unsigned int index, unsigned int primitiveCount, size_t* u
 
 		delete[] name; name = 0;
 
-		if(length == 0){
+		if(i == varyingCount){
 			std::cerr << "ERROR: Varying doesn't exist in program" << std::endl;
 			return FAILURE;
 		}
@@ -102,9 +149,11 @@ bool Varying::prepare(unsigned int index, unsigned int primitiveCount, size_t* u
 		if(!TypeResolver::resolve(type, m_glslType))
 			return FAILURE;
 
-		//DRIVER ISSUE
-		if(m_glslType.getColumnCount() > 1 && !m_output.isInterleaved()){
-			std::cerr << "ERROR: Transform feedback in separate attribs mode can't be used whit matrices (break to vectors or use interleaved mode)" << std::endl;
+		//each varying recorded in separate attribs mode is limited in number of components
+		int components = m_glslType.getColumnCount() * m_glslType.getColumnSize();
+		if(!m_output.isInterleaved() && !m_output.m_separateByBuffers && components > m_output.m_maxSeparateComponents){
+			std::cerr << "ERROR: Varying " << m_name << " has " << components << " components, but transform feedback in separate attribs mode can record only "
+				<< m_output.m_maxSeparateComponents << " per varying without ARB_transform_feedback3 (break to vectors or use interleaved mode)" << std::endl;
 			return FAILURE;
 		}
 
@@ -130,15 +179,30 @@ bool Varying::prepare(unsigned int index, unsigned int primitiveCount, size_t* u
 	if(unitSize)
 		*unitSize = m_unitSize;
 
-	if(!m_output.isInterleaved()){
+	if(!m_output.isInterleaved() && m_connectedBuffer){
+		if(m_connectedBuffer->getByteSize() < m_unitSize * primitiveCount){
+			std::cerr << "ERROR: Buffer connected to varying " << m_name << " is too small" << std::endl;
+			return FAILURE;
+		}
+	}
+	else if(!m_output.isInterleaved()){
+		std::shared_ptr<InternalBuffer> buffer = std::static_pointer_cast<InternalBuffer>(m_buffer);
+		buffer->setGrowthFactor(m_output.getGrowthFactor());
+		buffer->reserve(m_unitSize * m_output.getReservedCount() * m_output.getMaxOutputsPerPrimitive());
+
 		bufSize = m_unitSize * primitiveCount;
-		if(bufSize != std::static_pointer_cast<InternalBuffer>(m_buffer)->getSize() && bufSize != 0)
-			std::static_pointer_cast<InternalBuffer>(m_buffer)->resize(bufSize);
+		if(bufSize != buffer->getSize() && bufSize != 0 && !buffer->resize(bufSize))
+			return FAILURE;
 	}
 
 	return SUCCESS;
 }
 
+void Varying::shrinkToFit(){
+	if(!m_output.isInterleaved())
+		std::static_pointer_cast<InternalBuffer>(m_buffer)->shrinkToFit();
+}
+
 bool Varying::handleSignal(unsigned int signalID, const ObjectBase* callerPtr){
 	if(callerPtr->getClassName() == "us::ShaderProgram"){
 		switch(signalID){
@@ -151,13 +215,23 @@ bool Varying::handleSignal(unsigned int signalID, const ObjectBase* callerPtr){
 		switch(signalID){
 		case ShaderOutput::SignalID::INTERLEAVED:
 			m_buffer = 0;
+			m_connectedBuffer = 0;
 			return SUCCESS;
 		case ShaderOutput::SignalID::DEINTERLEAVED:
-			m_buffer = BufferBase::Ptr(std::dynamic_pointer_cast<BufferBase>(InternalBuffer::create()));
-			m_buffer->setFrequencyMode(BufferBase::FrequencyMode::DYNAMIC);
-			m_buffer->setNatureMode(BufferBase::NatureMode::COPY);
+			m_bufferOffset = 0;
+			createBuffer();
+			return SUCCESS;
+		case ShaderOutput::SignalID::ARENA_CHANGED:
+			if(!m_output.isInterleaved())
+				createBuffer();
 			return SUCCESS;
 		}
 	}
 	return FAILURE;
 }
+
+void Varying::createBuffer(){
+	m_buffer = BufferBase::Ptr(std::dynamic_pointer_cast<BufferBase>(InternalBuffer::create(m_output.getArena())));
+	m_buffer->setFrequencyMode(BufferBase::FrequencyMode::DYNAMIC);
+	m_buffer->setNatureMode(BufferBase::NatureMode::COPY);
+}